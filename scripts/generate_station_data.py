@@ -0,0 +1,160 @@
+"""
+Generates src/config/station_data.h from the station settings in platformio.ini.
+
+Runs as a PlatformIO pre-build extra script, or standalone:
+    python scripts/generate_station_data.py --station-id 8447525
+
+Copyright (c) 2025 Bernard Bernstein
+MIT License - See LICENSE file in the project root for full license information.
+"""
+
+import argparse
+import json
+import os
+
+DEFAULTS = {
+    "station_id": "8447525",
+    "latitude": "41.6540367",
+    "longitude": "-70.1630046",
+    "num_leds": "1",
+    "log_level": "debug",
+}
+
+LOG_LEVELS = ("none", "error", "info", "debug")
+
+# Longest station id a device profile can hold; matches the 12-byte,
+# NUL-padded station field in tide table headers
+STATION_ID_CAPACITY = 11
+
+# Placeholder for each datetime; same width as "%Y-%m-%dT%H:%M:%S"
+DATETIME_PLACEHOLDER = "0000-00-00T00:00:00"
+
+GRAPHQL_QUERY = (
+    "query GetTides($stationId: ID!, $startDateTime: String!, $endDateTime: String!) {\n"
+    "  tides(\n"
+    "    stationId: $stationId\n"
+    "    startDateTime: $startDateTime\n"
+    "    endDateTime: $endDateTime\n"
+    "  ) {\n"
+    "    localTime\n"
+    "    waterLevel\n"
+    "    tideType\n"
+    "    timeZoneOffsetSeconds\n"
+    "    extremes {\n"
+    "      type\n"
+    "      timestamp\n"
+    "      height\n"
+    "    }\n"
+    "  }\n"
+    "}"
+)
+
+
+def c_string(text):
+    escaped = text.replace("\\", "\\\\").replace('"', '\\"').replace("\n", "\\n")
+    return '"' + escaped + '"'
+
+
+def build_query_template():
+    """Splits the request body around the station id, which is set at runtime.
+
+    Returns the text before and after the id, and the datetime offsets within
+    the second part.
+    """
+    station_marker = "@STATION@"
+    start_marker = "@START@"
+    end_marker = "@END@"
+    body = json.dumps({
+        "operationName": "GetTides",
+        "variables": {
+            "stationId": station_marker,
+            "startDateTime": start_marker,
+            "endDateTime": end_marker,
+        },
+        "query": GRAPHQL_QUERY,
+    }, separators=(",", ":"))
+    head, tail = body.split(station_marker)
+    start_offset = tail.index(start_marker)
+    tail = tail.replace(start_marker, DATETIME_PLACEHOLDER, 1)
+    end_offset = tail.index(end_marker)
+    tail = tail.replace(end_marker, DATETIME_PLACEHOLDER, 1)
+    return head, tail, start_offset, end_offset
+
+
+def render_header(settings):
+    station_id = settings["station_id"]
+    log_level = settings["log_level"].lower()
+    if log_level not in LOG_LEVELS:
+        raise ValueError("custom_log_level must be one of " + ", ".join(LOG_LEVELS))
+    num_leds = int(settings["num_leds"])
+    if num_leds < 1:
+        raise ValueError("custom_num_leds must be at least 1")
+
+    if not station_id.isalnum() or len(station_id) > STATION_ID_CAPACITY:
+        raise ValueError("custom_station_id must be up to %d letters or digits" % STATION_ID_CAPACITY)
+    query_head, query_tail, start_offset, end_offset = build_query_template()
+
+    lines = [
+        "// Generated by scripts/generate_station_data.py - do not edit.",
+        "// Change the custom_* options in platformio.ini instead.",
+        "#pragma once",
+        "#include <cstddef>",
+        "#include <cstdint>",
+        "",
+        "// Station defaults; a profile saved in NVS overrides them at runtime",
+        "constexpr size_t STATION_ID_CAPACITY = %d;" % STATION_ID_CAPACITY,
+        "constexpr char DEFAULT_STATION_ID[] = %s;" % c_string(station_id),
+        "constexpr double DEFAULT_LATITUDE = %s;" % float(settings["latitude"]),
+        "constexpr double DEFAULT_LONGITUDE = %s;" % float(settings["longitude"]),
+        "",
+        "// Feature selection",
+        "constexpr int NUM_LEDS = %d;" % num_leds,
+        "constexpr int LOG_LEVEL_SETTING = %d;  // %s" % (LOG_LEVELS.index(log_level), log_level),
+        "",
+        "// GraphQL request body, split around the station id; the tail holds",
+        "// placeholders for the two datetimes at the given offsets",
+        "constexpr char QUERY_HEAD[] = %s;" % c_string(query_head),
+        "constexpr char QUERY_TAIL[] = %s;" % c_string(query_tail),
+        "constexpr size_t QUERY_START_OFFSET = %d;" % start_offset,
+        "constexpr size_t QUERY_END_OFFSET = %d;" % end_offset,
+        "constexpr size_t QUERY_DATETIME_LENGTH = %d;" % len(DATETIME_PLACEHOLDER),
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def write_if_changed(path, content):
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == content:
+                return False
+    with open(path, "w") as f:
+        f.write(content)
+    return True
+
+
+def generate(project_dir, settings):
+    output = os.path.join(project_dir, "src", "config", "station_data.h")
+    if write_if_changed(output, render_header(settings)):
+        print("Generated " + os.path.relpath(output, project_dir))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    for key, value in DEFAULTS.items():
+        parser.add_argument("--" + key.replace("_", "-"), default=value)
+    args = parser.parse_args()
+    project_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    generate(project_dir, vars(args))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+except NameError:
+    if __name__ == "__main__":
+        main()
+else:
+    generate(env.subst("$PROJECT_DIR"), {  # noqa: F821
+        key: env.GetProjectOption("custom_" + key, value)  # noqa: F821
+        for key, value in DEFAULTS.items()
+    })
@@ -0,0 +1,70 @@
+"""
+Records tide API responses for the replay environment.
+
+Writes replay/tide_responses.txt with one "<fetch epoch> <json>" line per
+fetch, stepping through the given range the way the device would, followed
+by an "<epoch> END" line. Build and run the replay with:
+    python scripts/record_tide_responses.py --station-id 8447525 --start 2025-01-01 --days 30
+    pio run -e replay -t upload && pio device monitor
+
+Copyright (c) 2025 Bernard Bernstein
+MIT License - See LICENSE file in the project root for full license information.
+"""
+
+import argparse
+import datetime
+import json
+import os
+import urllib.request
+
+from generate_station_data import GRAPHQL_QUERY
+
+API_ENDPOINT = "https://api.flowebb.com/graphql"
+FETCH_INTERVAL = 6 * 3600   # TideData::UPDATE_INTERVAL
+WINDOW_BEFORE = 24 * 3600   # Same window as TideService::fetchTideData
+WINDOW_AFTER = 5 * 24 * 3600
+
+
+def fetch(endpoint, station_id, start, end):
+    body = json.dumps({
+        "operationName": "GetTides",
+        "variables": {
+            "stationId": station_id,
+            "startDateTime": start.strftime("%Y-%m-%dT%H:%M:%S"),
+            "endDateTime": end.strftime("%Y-%m-%dT%H:%M:%S"),
+        },
+        "query": GRAPHQL_QUERY,
+    }).encode()
+    request = urllib.request.Request(endpoint, data=body, headers={"Content-Type": "application/json"})
+    with urllib.request.urlopen(request, timeout=30) as response:
+        # Re-serialize compactly so each response stays on one line
+        return json.dumps(json.load(response), separators=(",", ":"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--station-id", default="8447525")
+    parser.add_argument("--start", required=True, help="YYYY-MM-DD, UTC")
+    parser.add_argument("--days", type=int, default=14)
+    parser.add_argument("--endpoint", default=API_ENDPOINT)
+    args = parser.parse_args()
+
+    start = datetime.datetime.strptime(args.start, "%Y-%m-%d").replace(tzinfo=datetime.timezone.utc)
+    first = int(start.timestamp())
+    last = first + args.days * 86400
+
+    project_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    output = os.path.join(project_dir, "replay", "tide_responses.txt")
+    os.makedirs(os.path.dirname(output), exist_ok=True)
+    with open(output, "w") as f:
+        for fetch_time in range(first, last, FETCH_INTERVAL):
+            now = datetime.datetime.fromtimestamp(fetch_time, datetime.timezone.utc)
+            window_start = now - datetime.timedelta(seconds=WINDOW_BEFORE)
+            window_end = now + datetime.timedelta(seconds=WINDOW_AFTER)
+            f.write("%d %s\n" % (fetch_time, fetch(args.endpoint, args.station_id, window_start, window_end)))
+            print("Recorded " + now.isoformat())
+        f.write("%d END\n" % last)
+
+
+if __name__ == "__main__":
+    main()
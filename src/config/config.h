@@ -1,46 +1,104 @@
 #pragma once
 #include <cstdint>
+#include <ctime>
+#include "station_data.h"  // Generated from platformio.ini by scripts/generate_station_data.py
+#include "features.h"
 
-// Station configuration
-const char* const TIDE_STATION_ID = "8447525";
+// Defaults for the device profile (see ConfigManager). Code reads the
+// active values through ConfigManager::get() rather than these directly.
 
 // Time configuration
-const int GMT_OFFSET_SEC = -18000;  // EST: UTC-5 = -5 * 3600 = -18000
-const int DAYLIGHT_OFFSET_SEC = 3600; // 1 hour DST
+constexpr int DEFAULT_GMT_OFFSET_SEC = -18000;  // EST: UTC-5 = -5 * 3600 = -18000
+constexpr int DEFAULT_DAYLIGHT_OFFSET_SEC = 3600; // 1 hour DST
 
-// Debug configuration
-const bool ENABLE_DEBUG_PRINTS = true;
+// Logging, from custom_log_level. Console replies (ConfigManager) and replay
+// timelines are always printed.
+constexpr bool ENABLE_ERROR_PRINTS = LogEnabled<LogLevel::Error>::value;
+constexpr bool ENABLE_INFO_PRINTS = LogEnabled<LogLevel::Info>::value;
+constexpr bool ENABLE_DEBUG_PRINTS = LogEnabled<LogLevel::Debug>::value;
 
 // NTP Server settings
-const char* const NTP_SERVER = "pool.ntp.org";
+constexpr char NTP_SERVER[] = "pool.ntp.org";
+constexpr unsigned long NTP_SYNC_TIMEOUT_MS = 10000;     // Give up waiting for SNTP after this long
+constexpr unsigned long NTP_RETRY_INTERVAL_MS = 300000;  // Wait this long after a sync attempt before another
+constexpr long TIME_SYNC_TOLERANCE_SEC = 30;             // Resync once the clock may be this far off
+constexpr float RTC_DRIFT_UNCERTAINTY_PPM = 500.0f;      // Assumed RTC error until drift has been measured
+constexpr time_t MIN_VALID_TIME = 1704067200;            // 2024-01-01; anything earlier was never set
 
 // NeoPixel LED configuration
-const int LED_PIN = 48;     // WS2812 LED is on GPIO48
-const int NUM_LEDS = 1;     // Only one LED
-const int BRIGHTNESS = 64;   // Reduced brightness for power saving
-const int TRANSITION_SPEED = 10;  // Transition speed in ms
+constexpr int LED_PIN = 48;     // WS2812 LED is on GPIO48
+constexpr int DEFAULT_BRIGHTNESS = 64;   // Reduced brightness for power saving
+constexpr int TRANSITION_SPEED = 10;  // Transition speed in ms
 
 // Power management configuration
-const unsigned long DEEP_SLEEP_DURATION = 300000000; // 5 minutes in microseconds
-const int WIFI_TIMEOUT = 30000;  // WiFi connection timeout in ms
-const int PROG_PIN = 0;     // GPIO0 is typically used for programming mode detection
-const int PROG_MODE_CHECK_DELAY = 500; // ms to wait before checking programming mode
+constexpr unsigned long DEEP_SLEEP_DURATION = 300000000; // 5 minutes in microseconds
+constexpr int WIFI_TIMEOUT = 30000;  // WiFi connection timeout in ms
+constexpr unsigned long WIFI_RETRY_INTERVAL_MS = 300000;  // Wait this long after a failed connect from loop()
+constexpr int PROG_PIN = 0;     // GPIO0 is typically used for programming mode detection
+constexpr int PROG_MODE_CHECK_DELAY = 20; // ms for the pin to settle before checking programming mode
 
-// User location
-const char* const LATITUDE = "41.6540367";
-const char* const LONGITUDE = "-70.1630046";
+// Boot sequence
+constexpr unsigned long SERIAL_WAIT_MS = 2000;         // Debug builds wait this long at most for a USB host
+constexpr unsigned long FIRST_PIXEL_BUDGET_MS = 250;   // Reset to first LED frame with an RTC cache; overruns are counted and reported
+constexpr uint8_t BOOT_FAILURE_LIMIT = 3;              // Failed boots in a row before booting degraded
+constexpr unsigned long BOOT_STABLE_MS = 60000;        // Uptime after which a boot counts as good
+constexpr unsigned long DEGRADED_RETRY_INTERVAL_MS = 30UL * 60 * 1000;  // Between fetch retries once restarts stop
 
 // Preferences settings
-const char* const PREF_NAMESPACE = "tidedata";
-const char* const TIDE_DATA_KEY = "tidestate";
+#ifdef REPLAY_MODE
+constexpr char PREF_NAMESPACE[] = "tidereplay";  // Keep replay runs away from real saved data
+constexpr char TIDE_TABLE_PATH[] = "/tides-replay.bin";
+constexpr char TIDE_TABLE_PENDING_PATH[] = "/tides-replay.tmp";
+#else
+constexpr char PREF_NAMESPACE[] = "tidedata";
+constexpr char TIDE_TABLE_PATH[] = "/tides.bin";
+constexpr char TIDE_TABLE_PENDING_PATH[] = "/tides.tmp";
+#endif
+constexpr char TIDE_DATA_KEY[] = "tidestate";
+constexpr char CONFIG_NAMESPACE[] = "tideconfig";  // Device profile, kept apart so clearing tide data leaves it alone
+constexpr char CONFIG_KEY[] = "profile";
 
 // LED colors
-const uint32_t COLOR_RED = 0xFF0000;   // For falling tide
-const uint32_t COLOR_GREEN = 0x00FF00;  // For rising tide
+constexpr uint32_t COLOR_RED = 0xFF0000;   // For falling tide
+constexpr uint32_t COLOR_GREEN = 0x00FF00;  // For rising tide
 
 // Wave animation parameters
-const unsigned long MIN_WAVE_INTERVAL = 10000;  // Minimum time between waves (ms)
-const unsigned long MAX_WAVE_INTERVAL = 20000;  // Maximum time between waves (ms)
+constexpr unsigned long DEFAULT_MIN_WAVE_INTERVAL = 30000;  // Minimum time between waves (ms)
+constexpr unsigned long DEFAULT_MAX_WAVE_INTERVAL = 60000;  // Maximum time between waves (ms)
+
+// LED frame rendering
+constexpr unsigned long FRAME_INTERVAL_MS = 1000;  // One LED update per second
+// Play precomputed frames from light sleep instead of a busy loop. USB serial
+// drops out while the CPU sleeps, so debug builds keep the polling loop.
+constexpr bool LIGHT_SLEEP_RENDERING = !ENABLE_DEBUG_PRINTS;
+
+// Energy model: estimated current draw in mA for each kind of awake interval
+constexpr float CURRENT_BOOT_MA = 50.0f;          // CPU at full clock, radio off
+constexpr float CURRENT_IDLE_MA = 25.0f;          // Main loop between LED frames
+constexpr float CURRENT_NVS_MA = 45.0f;           // Flash reads and writes
+constexpr float CURRENT_WIFI_ASSOCIATE_MA = 120.0f;
+constexpr float CURRENT_TLS_MA = 110.0f;          // Handshake and request
+constexpr float CURRENT_HTTP_MA = 95.0f;          // Receiving the response
+constexpr float CURRENT_PARSE_MA = 45.0f;
+constexpr float CURRENT_LIGHT_SLEEP_MA = 0.8f;    // Between precomputed LED frames
+constexpr float CURRENT_LED_CHANNEL_MA = 12.0f;   // One WS2812 channel at full value and brightness
+constexpr float BATTERY_CAPACITY_MAH = 2000.0f;
+
+// Push updates over MQTT (profile setting "push"); broker details are in wifi_credentials.h
+constexpr bool DEFAULT_PUSH_MODE = false;
+constexpr uint16_t PUSH_KEEPALIVE_SEC = 60;
+constexpr unsigned long PUSH_MIN_BACKOFF_MS = 1000;        // First retry after a lost connection
+constexpr unsigned long PUSH_MAX_BACKOFF_MS = 300000;      // Doubling stops here
+constexpr char PUSH_TOPIC_PREFIX[] = "tides/";             // + <station>/patch or <station>/level
+constexpr uint32_t PUSH_CONNECT_TIMEOUT_SEC = 2;           // Each of the TCP connect and the MQTT handshake
+constexpr unsigned long PUSH_CATCHUP_INTERVAL_MS = 60000;  // At most one HTTP catch-up this often
+constexpr uint8_t PUSH_PATCH_QUEUE_DEPTH = 2;              // Patches held from the MQTT callback until loop()
+constexpr long PUSH_LEVEL_MAX_AGE_SEC = 3600;              // Older level readings are dropped
+constexpr long PUSH_LEVEL_MAX_AHEAD_SEC = 300;             // As are ones from further in the future
+
+// Tide table provisioning
+constexpr long TABLE_CHECK_INTERVAL = 7L * 24 * 3600;  // Look for table patches weekly (seconds)
+constexpr long TABLE_RENEW_MARGIN = 30L * 24 * 3600;   // Fetch a new table this long before coverage ends
 
 // Update intervals
-const unsigned long TIDE_CHECK_INTERVAL = 900000; // Check every 15 minutes
+constexpr unsigned long DEFAULT_UPDATE_INTERVAL = 6 * 3600; // Refresh tide data every 6 hours (seconds)
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include "station_data.h"
+
+// Compile-time feature selection. The values come from the custom_* options
+// in platformio.ini, so disabled paths are removed by the compiler.
+
+enum class LogLevel : int {
+    None = 0,
+    Error = 1,
+    Info = 2,
+    Debug = 3
+};
+
+template <LogLevel Level>
+struct LogEnabled {
+    static constexpr bool value = Level != LogLevel::None &&
+                                  static_cast<int>(Level) <= LOG_LEVEL_SETTING;
+};
+
+// LED layout: a single pixel needs no loop, a strip fills every pixel
+template <int Count>
+struct PixelLayout {
+    template <typename Strip>
+    static void write(Strip& strip, uint32_t color) {
+        strip.fill(color, 0, Count);
+    }
+};
+
+template <>
+struct PixelLayout<1> {
+    template <typename Strip>
+    static void write(Strip& strip, uint32_t color) {
+        strip.setPixelColor(0, color);
+    }
+};
@@ -0,0 +1,23 @@
+// Generated by scripts/generate_station_data.py - do not edit.
+// Change the custom_* options in platformio.ini instead.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Station defaults; a profile saved in NVS overrides them at runtime
+constexpr size_t STATION_ID_CAPACITY = 11;
+constexpr char DEFAULT_STATION_ID[] = "8447525";
+constexpr double DEFAULT_LATITUDE = 41.6540367;
+constexpr double DEFAULT_LONGITUDE = -70.1630046;
+
+// Feature selection
+constexpr int NUM_LEDS = 1;
+constexpr int LOG_LEVEL_SETTING = 3;  // debug
+
+// GraphQL request body, split around the station id; the tail holds
+// placeholders for the two datetimes at the given offsets
+constexpr char QUERY_HEAD[] = "{\"operationName\":\"GetTides\",\"variables\":{\"stationId\":\"";
+constexpr char QUERY_TAIL[] = "\",\"startDateTime\":\"0000-00-00T00:00:00\",\"endDateTime\":\"0000-00-00T00:00:00\"},\"query\":\"query GetTides($stationId: ID!, $startDateTime: String!, $endDateTime: String!) {\\n  tides(\\n    stationId: $stationId\\n    startDateTime: $startDateTime\\n    endDateTime: $endDateTime\\n  ) {\\n    localTime\\n    waterLevel\\n    tideType\\n    timeZoneOffsetSeconds\\n    extremes {\\n      type\\n      timestamp\\n      height\\n    }\\n  }\\n}\"}";
+constexpr size_t QUERY_START_OFFSET = 19;
+constexpr size_t QUERY_END_OFFSET = 55;
+constexpr size_t QUERY_DATETIME_LENGTH = 19;
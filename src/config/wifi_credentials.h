@@ -0,0 +1,10 @@
+#pragma once
+const char* const WIFI_SSID = "x";
+const char* const WIFI_PASSWORD = "y";
+const char* const TIDE_API_ENDPOINT = "https://api.flowebb.com/graphql";
+const char* const TIDE_TABLE_URL = "https://api.flowebb.com/tables/";
+const uint8_t TIDE_TABLE_PUBLIC_KEY[65] = { 0x04 };
+const char* const MQTT_BROKER_HOST = "192.168.1.10";
+const uint16_t MQTT_BROKER_PORT = 1883;
+const char* const MQTT_USERNAME = "";
+const char* const MQTT_PASSWORD = "";
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+
+const int FRAME_QUEUE_CAPACITY = 60;  // One minute of frames at the normal one-second rate
+
+// Precomputed LED frames at a fixed interval, played back while the main
+// cores spend the time between frames in light sleep. No Arduino
+// dependencies, so the same layout can be produced and compared on the host.
+struct FrameQueue {
+    uint32_t startMillis;    // When frame 0 is due
+    uint16_t intervalMs;
+    uint16_t count;
+    uint32_t colors[FRAME_QUEUE_CAPACITY];  // 0xRRGGBB
+
+    void clear() { count = 0; }
+    bool full() const { return count >= FRAME_QUEUE_CAPACITY; }
+    bool push(uint32_t color) {
+        if (full()) return false;
+        colors[count++] = color;
+        return true;
+    }
+    uint32_t dueMillis(int index) const { return startMillis + (uint32_t)index * intervalMs; }
+
+    // Frames to queue at now, one per second, when fresh data is due at
+    // until. An until already passed means an update is due but could not
+    // run (offline, backing off or degraded); a full queue keeps the LED
+    // moving and the caller sleeping until it is time to retry.
+    static int framesBefore(time_t now, time_t until) {
+        if (until <= now || until - now > FRAME_QUEUE_CAPACITY) {
+            return FRAME_QUEUE_CAPACITY;
+        }
+        return (int)(until - now);
+    }
+};
@@ -0,0 +1,114 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "FrameRenderer.h"
+#include <cmath>
+
+FrameRenderer::FrameRenderer()
+    : waveStart(0), waveDuration(1), nextWave(0), waveStarted(false), randomState(1) {
+}
+
+void FrameRenderer::seed(uint32_t seed) {
+    randomState = seed ? seed : 1;  // xorshift never leaves zero
+    waveStarted = false;
+}
+
+bool FrameRenderer::render(const TideTimeline& extremes, const TideExtreme& current, const TideBlendState& blend,
+                           time_t now, uint32_t millis, const WaveSettings& wave, TideFrame& frame) {
+    if (extremes.empty()) return false;
+
+    // Find the next extreme after now; amortized O(1) as time moves forward
+    int nextIndex = cursor.next(extremes, now);
+
+    // If we're past all stored extremes, return early
+    if (nextIndex >= extremes.size()) {
+        return false;
+    }
+
+    // Observed levels can move the turn of the tide a little either way, so
+    // the interval is chosen by the corrected times rather than the table's
+    if (nextIndex > 0 && now < correctedTime(extremes, current, blend, nextIndex - 1, now)) {
+        nextIndex--;  // Running late: the previous extreme hasn't turned yet
+    } else if (nextIndex + 1 < extremes.size() && now >= correctedTime(extremes, current, blend, nextIndex, now)) {
+        nextIndex++;  // Running early: the next one already has
+    }
+
+    TideExtreme previous = nextIndex > 0 ? extremes.at(nextIndex - 1) : current;
+    TideExtreme next = extremes.at(nextIndex);
+    frame.estimate = TideBlend::estimate(blend, previous, next, now);
+    frame.previous = previous;
+    if (nextIndex > 0) {
+        frame.previous.timestamp = correctedTime(extremes, current, blend, nextIndex - 1, now);
+    }
+    frame.next = next;
+    frame.next.timestamp = frame.estimate.nextExtreme;
+
+    frame.progress = progress(frame.previous, frame.next, now);
+    frame.color = tideColor(frame.progress, frame.previous, waveLevel(millis, wave));
+    return true;
+}
+
+time_t FrameRenderer::correctedTime(const TideTimeline& extremes, const TideExtreme& current,
+                                   const TideBlendState& blend, int index, time_t now) {
+    TideExtreme previous = index > 0 ? extremes.at(index - 1) : current;
+    return TideBlend::estimate(blend, previous, extremes.at(index), now).nextExtreme;
+}
+
+uint32_t FrameRenderer::colorBetween(const TideExtreme& previous, const TideExtreme& next,
+                                     time_t now, uint32_t millis, const WaveSettings& wave) {
+    return tideColor(progress(previous, next, now), previous, waveLevel(millis, wave));
+}
+
+float FrameRenderer::progress(const TideExtreme& previous, const TideExtreme& next, time_t now) {
+    int64_t timeToNext = next.timestamp - now;
+    int64_t totalTime = next.timestamp - previous.timestamp;
+
+    float progress = 1.0 - ((float)timeToNext / totalTime);
+    // Past the last stored extreme the corrected time can still run out
+    return progress < 0 ? 0 : (progress > 1 ? 1 : progress);
+}
+
+uint8_t FrameRenderer::waveLevel(uint32_t millis, const WaveSettings& wave) {
+    const uint8_t MIN_BLUE = 0;
+    const uint8_t MAX_BLUE = 16; // Reduced max blue for power saving
+
+    if (millis >= nextWave || !waveStarted) {
+        uint32_t range = wave.maxIntervalMs > wave.minIntervalMs ? wave.maxIntervalMs - wave.minIntervalMs : 0;
+        waveDuration = wave.minIntervalMs + (range ? nextRandom() % range : 0);
+        if (waveDuration == 0) {
+            waveDuration = 1;
+        }
+        waveStart = millis;
+        nextWave = millis + waveDuration;
+        waveStarted = true;
+    }
+
+    // Calculate wave using optimized floating point
+    uint32_t cyclePosition = (millis - waveStart) % waveDuration;
+    float cycleProgress = (float)cyclePosition / waveDuration;
+    float waveValue = (sin(cycleProgress * 2 * M_PI) + 1.0f) / 2.0f; // Normalize to 0-1
+
+    return MIN_BLUE + (uint8_t)(waveValue * (MAX_BLUE - MIN_BLUE));
+}
+
+uint32_t FrameRenderer::tideColor(float progress, const TideExtreme& previous, uint8_t blue) {
+    uint32_t prevColorValue = (uint8_t)(0xFF * progress) << (previous.isHigh ? 16 : 8);
+    uint32_t nextColorValue = (uint8_t)(0xFF * (1 - progress)) << (previous.isHigh ? 8 : 16);
+    uint32_t baseColor = prevColorValue | nextColorValue;
+
+    uint8_t red = (baseColor >> 16) & 0xFF;
+    uint8_t green = (baseColor >> 8) & 0xFF;
+
+    return ((uint32_t)red << 16) | ((uint32_t)green << 8) | blue;
+}
+
+uint32_t FrameRenderer::nextRandom() {
+    // xorshift32: the renderer owns its sequence, so the host sees the same draws
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include "../models/TideTimeline.h"
+#include "../models/TideBlend.h"
+
+// Wave timing, from the device profile
+struct WaveSettings {
+    uint32_t minIntervalMs;
+    uint32_t maxIntervalMs;
+};
+
+struct TideFrame {
+    uint32_t color;          // 0xRRGGBB
+    float progress;          // From previous to next extreme, 0 to 1
+    TideExtreme previous;    // Both at the times the observed levels put them
+    TideExtreme next;
+    TideEstimate estimate;
+};
+
+// Turns the extremes and a clock into LED colours: red and green cross-fade
+// from one extreme to the next, with a slow blue wave on top. Keeps the
+// timeline cursor and the wave's phase and random draws between frames, so
+// frames must be rendered in time order; then a queue rendered ahead gives
+// the same colours as rendering each frame as it falls due.
+// No Arduino dependencies, so the two can be compared on the host.
+class FrameRenderer {
+public:
+    FrameRenderer();
+
+    void seed(uint32_t seed);
+
+    // False if the extremes don't reach past now
+    bool render(const TideTimeline& extremes, const TideExtreme& current, const TideBlendState& blend,
+                time_t now, uint32_t millis, const WaveSettings& wave, TideFrame& frame);
+    // Colour between two known extremes, for the cached first frame
+    uint32_t colorBetween(const TideExtreme& previous, const TideExtreme& next,
+                          time_t now, uint32_t millis, const WaveSettings& wave);
+
+    static float progress(const TideExtreme& previous, const TideExtreme& next, time_t now);
+
+private:
+    // When the extreme at index turns, given the blend as of now
+    static time_t correctedTime(const TideTimeline& extremes, const TideExtreme& current,
+                                const TideBlendState& blend, int index, time_t now);
+    uint8_t waveLevel(uint32_t millis, const WaveSettings& wave);
+    static uint32_t tideColor(float progress, const TideExtreme& previous, uint8_t blue);
+    uint32_t nextRandom();
+
+    TideTimeline::Cursor cursor;
+    uint32_t waveStart;
+    uint32_t waveDuration;
+    uint32_t nextWave;
+    bool waveStarted;
+    uint32_t randomState;
+};
@@ -5,120 +5,171 @@
  */
 
 #include "LedController.h"
+#include "../services/ReplayService.h"
+#include "../services/EnergyMonitor.h"
+#include "../services/BootSequence.h"
+#include "../storage/ConfigManager.h"
+
+namespace {
+
+const uint32_t FRAME_CACHE_MAGIC = 0x46524D43;  // "FRMC"
+
+// The extremes either side of the last frame. Survives deep sleep and resets.
+struct FrameCache {
+    uint32_t magic;
+    TideExtreme previous;
+    TideExtreme next;
+};
+
+RTC_DATA_ATTR FrameCache frameCache;
+
+}
 
 Adafruit_NeoPixel LedController::pixel(NUM_LEDS, LED_PIN, NEO_GRB + NEO_KHZ800);
-uint8_t LedController::currentBlueLevel = 0;
-unsigned long LedController::nextWaveTime = 0;
 unsigned long LedController::lastPrintTime = 0;
+uint32_t LedController::shownColor = 0;
+unsigned long LedController::shownSince = 0;
+FrameQueue LedController::frameQueue;
+bool LedController::refreshPending = false;
+unsigned long LedController::refreshRequestedAt = 0;
+FrameRenderer LedController::renderer;
 
 void LedController::initialize() {
     pixel.begin();
-    pixel.setBrightness(BRIGHTNESS);
-    pixel.setPixelColor(0, 0); // Start with LED off
+    pixel.setBrightness(ConfigManager::get().brightness);
+    PixelLayout<NUM_LEDS>::write(pixel, 0); // Start with LED off
     pixel.show();
-    Serial.println("NeoPixel LED initialized");
+    renderer.seed(random(1, INT32_MAX));
+    if (ENABLE_INFO_PRINTS) {
+        Serial.println("NeoPixel LED initialized");
+    }
+}
+
+bool LedController::showCachedFrame() {
+    time_t now = TimeService::getCurrentTime();
+    if (frameCache.magic != FRAME_CACHE_MAGIC || !TimeService::isSynced() ||
+        now < frameCache.previous.timestamp || now >= frameCache.next.timestamp) {
+        return false;
+    }
+    unsigned long currentMillis = TimeService::getMillis();
+    showColor(renderer.colorBetween(frameCache.previous, frameCache.next, now, currentMillis, waveSettings()),
+              currentMillis);
+    return true;
 }
 
 void LedController::updateDisplay(const TideData& tideData) {
     static unsigned long lastUpdateTime = 0;
-    const unsigned long UPDATE_INTERVAL = 1000; // Update LED every second
     
-    unsigned long currentMillis = millis();
-    if (currentMillis - lastUpdateTime < UPDATE_INTERVAL) {
+    unsigned long currentMillis = TimeService::getMillis();
+    if (!refreshPending && currentMillis - lastUpdateTime < FRAME_INTERVAL_MS) {
         return; // Skip update if not enough time has passed
     }
     lastUpdateTime = currentMillis;
     
-    if (tideData.numExtremes == 0) return;
-    
+    uint32_t color;
+    if (renderFrame(tideData, TimeService::getCurrentTime(), currentMillis, color)) {
+        showColor(color, currentMillis);
+    }
+}
+
+void LedController::playFrames(const TideData& tideData, time_t until) {
+    unsigned long startMillis = TimeService::getMillis();
     time_t now = TimeService::getCurrentTime();
     
-    // If we're past all stored extremes, return early
-    if (now > tideData.extremes[tideData.numExtremes - 2].timestamp) {
-        return;
+    // Render the coming seconds up front, exactly as updateDisplay would one at a time
+    frameQueue.clear();
+    frameQueue.startMillis = startMillis;
+    frameQueue.intervalMs = FRAME_INTERVAL_MS;
+    int frames = FrameQueue::framesBefore(now, until);
+    for (int i = 0; i < frames; i++) {
+        uint32_t color;
+        if (!renderFrame(tideData, now + i, frameQueue.dueMillis(i), color)) {
+            break;
+        }
+        frameQueue.push(color);
     }
-
-    TideExtreme currentExtreme = tideData.current;
-    int nextIndex = 0;
-    if (now > tideData.extremes[0].timestamp) {
-        // find last extreme before now
-        for (int i = tideData.numExtremes - 1; i >= 0; i--) {
-            if (tideData.extremes[i].timestamp <= now) {
-                currentExtreme = tideData.extremes[i];
-                nextIndex = i + 1;
-                break;
-            }
+    
+    // Then sleep between frames; the LED latches its colour while the cores are off
+    for (int i = 0; i < frameQueue.count; i++) {
+        showColor(frameQueue.colors[i], TimeService::getMillis());
+        long remaining = (long)(frameQueue.dueMillis(i + 1) - TimeService::getMillis());
+        if (remaining > 0) {
+            TimeService::lightSleep(remaining);
         }
     }
+}
+
+void LedController::requestRefresh(unsigned long since) {
+    refreshPending = true;
+    refreshRequestedAt = since;
+}
 
-    // set nextExtreme to the next extreme after now
-    const TideExtreme& nextExtreme = tideData.extremes[nextIndex];
+bool LedController::renderFrame(const TideData& tideData, time_t now, unsigned long currentMillis, uint32_t& color) {
+    // An unset clock would put the tide anywhere, so show nothing until NTP has run
+    if (!TimeService::isSynced()) return false;
 
-    // Calculate progress and update animation
-    float progress = calculateTideProgress(currentExtreme, nextExtreme, now);
-    updateWaveAnimation(currentMillis);
-    uint32_t color = calculateTideColor(progress, currentExtreme, nextExtreme);
+    TideFrame frame;
+    if (!renderer.render(tideData.extremes, tideData.current, tideData.blend, now, currentMillis,
+                         waveSettings(), frame)) {
+        return false;
+    }
+    if (frameCache.magic != FRAME_CACHE_MAGIC || frameCache.next.timestamp != frame.next.timestamp) {
+        frameCache.previous = frame.previous;
+        frameCache.next = frame.next;
+        frameCache.magic = FRAME_CACHE_MAGIC;
+    }
+    color = frame.color;
     
     // Debug output (reduced frequency)
     if (ENABLE_DEBUG_PRINTS && currentMillis - lastPrintTime >= 60000) { // Every minute
-        debugPrintStatus(progress, color, nextExtreme);
+        debugPrintStatus(frame.progress, color, frame.next, frame.estimate, now);
         lastPrintTime = currentMillis;
     }
-
-    pixel.setPixelColor(0, color);
-    pixel.show();
+    return true;
 }
 
-float LedController::calculateTideProgress(const TideExtreme& current, const TideExtreme& next, time_t now) {
-    int64_t timeToNext = next.timestamp - now;
-    int64_t totalTime = next.timestamp - current.timestamp;
-    
-    return 1.0 - ((float)timeToNext / totalTime);
-}
+void LedController::showColor(uint32_t color, unsigned long currentMillis) {
+    // The LED has been holding the last colour since it was shown
+    EnergyMonitor::addLedFrame(shownColor, currentMillis - shownSince);
+    shownSince = currentMillis;
 
-void LedController::updateWaveAnimation(unsigned long currentMillis) {
-    static unsigned long waveCycleStartTime = 0;
-    static unsigned long waveCycleDuration = 0;
-    const uint8_t MIN_BLUE = 0;
-    const uint8_t MAX_BLUE = 16; // Reduced max blue for power saving
-    
-    // Increased wave intervals for power saving
-    const unsigned long MIN_WAVE_INTERVAL = 30000;  // 30 seconds
-    const unsigned long MAX_WAVE_INTERVAL = 60000;  // 60 seconds
-
-    if ((currentMillis >= nextWaveTime) || (waveCycleStartTime == 0)) {
-        waveCycleDuration = random(MIN_WAVE_INTERVAL, MAX_WAVE_INTERVAL);
-        waveCycleStartTime = currentMillis;
-        nextWaveTime = currentMillis + waveCycleDuration;
+    // Log tide colour changes; the blue wave would flood the replay timeline
+    static uint32_t lastTideColor = 0;
+    if ((color & 0xFFFF00) != lastTideColor) {
+        lastTideColor = color & 0xFFFF00;
+        ReplayService::logEvent("LED", "%06X", (unsigned int)color);
     }
-    
-    // Calculate wave using optimized floating point
-    uint32_t cyclePosition = (currentMillis - waveCycleStartTime) % waveCycleDuration;
-    float cycleProgress = (float)cyclePosition / waveCycleDuration;
-    float waveValue = (sin(cycleProgress * 2 * PI) + 1.0f) / 2.0f; // Normalize to 0-1
-    
-    currentBlueLevel = MIN_BLUE + (uint8_t)(waveValue * (MAX_BLUE - MIN_BLUE));
-}
 
-uint32_t LedController::calculateTideColor(float progress, const TideExtreme& current, const TideExtreme& next) {
-    uint32_t prevColorValue = (uint8_t)(0xFF * progress) << (current.isHigh ? 16 : 8);
-    uint32_t nextColorValue = (uint8_t)(0xFF * (1 - progress)) << (current.isHigh ? 8 : 16);
-    uint32_t baseColor = prevColorValue | nextColorValue;
+    PixelLayout<NUM_LEDS>::write(pixel, color);
+    pixel.show();
+    shownColor = color;
+    BootSequence::markFirstPixel();
 
-    uint8_t red = (baseColor >> 16) & 0xFF;
-    uint8_t green = (baseColor >> 8) & 0xFF;
+    if (refreshPending) {
+        refreshPending = false;
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.printf("LED refreshed %lu ms after update\n", TimeService::getMillis() - refreshRequestedAt);
+        }
+    }
+}
 
-    return ((uint32_t)red << 16) | ((uint32_t)green << 8) | currentBlueLevel;
+WaveSettings LedController::waveSettings() {
+    const DeviceConfig& config = ConfigManager::get();
+    WaveSettings wave = { config.minWaveIntervalMs, config.maxWaveIntervalMs };
+    return wave;
 }
 
-void LedController::debugPrintStatus(float progress, uint32_t color, const TideExtreme& nextExtreme) {
+void LedController::debugPrintStatus(float progress, uint32_t color, const TideExtreme& nextExtreme,
+                                     const TideEstimate& estimate, time_t now) {
     if (!ENABLE_DEBUG_PRINTS) return;
     
-    time_t now = TimeService::getCurrentTime();
     unsigned long timeToNext = nextExtreme.timestamp - now;
     
     Serial.printf("Time until %s: %s - progress: %.2f, Color: %06X\n", 
         (nextExtreme.isHigh ? "HIGH" : "LOW"), 
         TimeService::formatSecondsToTime(timeToNext).c_str(),
         progress, color);
+    Serial.printf("Height %.2f m (predicted %.2f, observed offset %+.2f +/- %.2f)\n",
+        estimate.height, estimate.predicted, estimate.offset, estimate.stddev);
+    EnergyMonitor::printSummary();
 }
@@ -4,21 +4,38 @@
 #include "../models/TideData.h"
 #include "../config/config.h"
 #include "../services/TimeService.h"
+#include "FrameQueue.h"
+#include "FrameRenderer.h"
 
 class LedController {
 public:
     static void initialize();
+    // Shows the frame for now from the extremes cached in RTC memory, so the
+    // LED lights before storage is read. False if the cache doesn't cover now.
+    static bool showCachedFrame();
     static void updateDisplay(const TideData& tideData);
+    // Precompute frames up to a FrameQueue's worth or until, and play them
+    // from timer-woken light sleep. An until that has already passed still
+    // plays a full queue.
+    static void playFrames(const TideData& tideData, time_t until);
+    // Render on the next updateDisplay instead of waiting out the frame
+    // interval, and log the latency from since to the LED changing
+    static void requestRefresh(unsigned long since);
 
 private:
     static Adafruit_NeoPixel pixel;
-    static uint8_t currentBlueLevel;
-    static unsigned long nextWaveTime;
 
-    static float calculateTideProgress(const TideExtreme& current, const TideExtreme& next, time_t now);
-    static void updateWaveAnimation(unsigned long currentMillis);
-    static uint32_t calculateTideColor(float progress, const TideExtreme& current, const TideExtreme& next);
-    static void debugPrintStatus(float progress, uint32_t color, const TideExtreme& nextExtreme);
+    static bool renderFrame(const TideData& tideData, time_t now, unsigned long currentMillis, uint32_t& color);
+    static void showColor(uint32_t color, unsigned long currentMillis);
+    static WaveSettings waveSettings();
+    static void debugPrintStatus(float progress, uint32_t color, const TideExtreme& nextExtreme,
+                                 const TideEstimate& estimate, time_t now);
 
     static unsigned long lastPrintTime;
+    static uint32_t shownColor;
+    static unsigned long shownSince;
+    static FrameQueue frameQueue;
+    static bool refreshPending;
+    static unsigned long refreshRequestedAt;
+    static FrameRenderer renderer;
 };
@@ -12,58 +12,151 @@
 #include "services/WiFiService.h"
 #include "services/TideService.h"
 #include "storage/PreferencesManager.h"
+#include "storage/TideTableStore.h"
+#include "storage/ConfigManager.h"
 #include "display/LedController.h"
 #include "utils/JsonHelper.h"
+#include "services/ReplayService.h"
+#include "services/EnergyMonitor.h"
+#include "services/ProvisioningService.h"
+#include "services/PushService.h"
+#include "services/BootSequence.h"
 
 // Global state
 TideData tideData;
 unsigned long lastTideCheck = 0;
 int retryCount = 0;
+bool backingOff = false;         // Fetches failed and restarting didn't help
+unsigned long backoffStart = 0;
+bool wifiFailed = false;         // The last connect from loop() timed out
+unsigned long wifiFailedAt = 0;
+
+// Long uptimes fragment the heap, so report how it looks after each fetch cycle
+void printHeapStats(const char* label) {
+    if (!ENABLE_DEBUG_PRINTS) return;
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t largestBlock = ESP.getMaxAllocHeap();
+    uint32_t fragmentation = freeHeap > 0 ? 100 - (largestBlock * 100 / freeHeap) : 0;
+    Serial.printf("Heap after %s: free %u, largest block %u, min free %u, fragmentation %u%%\n",
+        label, freeHeap, largestBlock, ESP.getMinFreeHeap(), fragmentation);
+}
+
+// Serve tide data from the provisioned table when it covers now, without WiFi
+bool loadFromTable(time_t now) {
+    return !ProvisioningService::isCheckDue(now) && TideTableStore::loadWindow(tideData, now);
+}
+
+// Each failed connect blocks for WIFI_TIMEOUT, so loop() waits
+// WIFI_RETRY_INTERVAL_MS before trying again
+bool connectForUpdate() {
+    if (wifiFailed && TimeService::getMillis() - wifiFailedAt < WIFI_RETRY_INTERVAL_MS) {
+        return false;
+    }
+    wifiFailed = !WiFiService::connect();
+    if (wifiFailed) {
+        wifiFailedAt = TimeService::getMillis();
+    }
+    return !wifiFailed;
+}
+
+// Push mode keeps WiFi up for the broker connection
+void releaseWiFi() {
+    if (!ConfigManager::get().pushMode) {
+        WiFiService::disconnect();
+    }
+}
+
+// Fetch what push mode missed over HTTP. Runs after the frame is drawn and
+// at most once per PUSH_CATCHUP_INTERVAL_MS, since the download blocks
+void catchUpPush() {
+    if (!PushService::takeCatchUp(TimeService::getMillis())) {
+        return;
+    }
+    time_t now = TimeService::getCurrentTime();
+    unsigned long start = TimeService::getMillis();
+    if (ProvisioningService::updateTables(now) && TideTableStore::loadWindow(tideData, now)) {
+        LedController::requestRefresh(start);
+    } else {
+        PushService::requestCatchUp();  // Try again next interval
+    }
+}
+
+// Restart after repeated fetch failures; once restarts stop helping,
+// wait a while before trying again instead
+void handleFetchFailure() {
+    if (++retryCount < 3) return;
+    retryCount = 0;
+    BootSequence::recover("Tide data fetch");
+    backingOff = true;
+    backoffStart = TimeService::getMillis();
+}
 
 void tryInitialDataLoad() {
     bool hasValidData = false;
-    Serial.println("Starting initial data load...");
-    
-    // Add a small delay to make sure everything is ready
-    delay(100);
+    if (ENABLE_INFO_PRINTS) {
+        Serial.println("Starting initial data load...");
+    }
     
     // Try to load saved tide data first
-    Serial.println("Attempting to load saved data...");
+    if (ENABLE_INFO_PRINTS) {
+        Serial.println("Attempting to load saved data...");
+    }
     if (PreferencesManager::loadTideData(tideData)) {
-        Serial.println("Successfully loaded saved data, checking validity...");
+        if (ENABLE_INFO_PRINTS) {
+            Serial.println("Successfully loaded saved data, checking validity...");
+        }
         time_t now = TimeService::getCurrentTime();
         
         // Check if saved data is still valid
         if (!tideData.needsUpdate(now)) {
-            Serial.println("Using saved tide data");
+            if (ENABLE_INFO_PRINTS) {
+                Serial.println("Using saved tide data");
+            }
             hasValidData = true;
-        } else {
+        } else if (ENABLE_INFO_PRINTS) {
             Serial.println("Saved data is too old or expired, fetching new data");
         }
-    } else {
+    } else if (ENABLE_INFO_PRINTS) {
         Serial.println("No valid saved data found");
     }
     
+    // WiFi is up, so this is the time to download or patch the tide table
+    if (!hasValidData) {
+        time_t now = TimeService::getCurrentTime();
+        if (ProvisioningService::isCheckDue(now)) {
+            ProvisioningService::updateTables(now);
+        }
+        if (TideTableStore::loadWindow(tideData, now)) {
+            if (ENABLE_INFO_PRINTS) {
+                Serial.println("Using tide table");
+            }
+            hasValidData = true;
+        }
+    }
+    
     // Fetch new data if needed
     if (!hasValidData) {
-        Serial.println("Attempting to fetch new tide data...");
+        if (ENABLE_INFO_PRINTS) {
+            Serial.println("Attempting to fetch new tide data...");
+        }
         if (TideService::fetchTideData(tideData)) {
-            Serial.println("Initial tide data fetched successfully");
-            delay(100); // Small delay before saving
+            if (ENABLE_INFO_PRINTS) {
+                Serial.println("Initial tide data fetched successfully");
+            }
             if (PreferencesManager::saveTideData(tideData)) {
-                Serial.println("New data saved successfully");
-            } else {
+                if (ENABLE_INFO_PRINTS) {
+                    Serial.println("New data saved successfully");
+                }
+            } else if (ENABLE_ERROR_PRINTS) {
                 Serial.println("Failed to save new data");
             }
+            printHeapStats("initial fetch");
             retryCount = 0;
         } else {
-            Serial.println("Failed to fetch initial tide data");
-            if (++retryCount >= 3) {
-                Serial.println("Too many failures, rebooting...");
-                delay(1000);
-                ESP.restart();
+            if (ENABLE_ERROR_PRINTS) {
+                Serial.println("Failed to fetch initial tide data");
             }
-            delay(1000); // Wait before retry
+            handleFetchFailure();
         }
     }
 }
@@ -79,89 +172,172 @@ bool inProgrammingMode() {
 }
 
 void setup() {
+    BootSequence::begin();
+    Serial.begin(115200);  // The config console answers at every log level
     if (ENABLE_DEBUG_PRINTS) {
         pinMode(PROG_PIN, OUTPUT);
         digitalWrite(PROG_PIN, LOW);
-
-        Serial.begin(115200);
-        delay(1000);  // Give USB CDC time to initialize
-        while (!Serial) delay(100);  // Wait for Serial to be ready
+    }
+    
+    BootSequence::enter(BootStage::CONFIG);
+    ConfigManager::initialize();
+    ReplayService::begin();
+    EnergyMonitor::beginWake();
+    
+    // Light the LED from the RTC cache before anything slow
+    BootSequence::enter(BootStage::FIRST_PIXEL);
+    LedController::initialize();
+    LedController::showCachedFrame();
+    
+    if (ENABLE_DEBUG_PRINTS) {
+        // Bounded, so a debug build still runs without a USB host
+        BootSequence::enter(BootStage::SERIAL_WAIT);
+        unsigned long waitStart = millis();
+        while (!Serial && millis() - waitStart < SERIAL_WAIT_MS) delay(10);
         Serial.println("ESP32-S3 Tide Tracker Starting...");
     }
     
     // Check if we're in programming mode
+    BootSequence::enter(BootStage::PROG_CHECK);
     if (inProgrammingMode()) {
         if (ENABLE_DEBUG_PRINTS) {
             Serial.println("Programming mode detected, disabling deep sleep");
         }
+        EnergyMonitor::enterPhase(PowerPhase::IDLE);
+        BootSequence::finish();
         return;
     }
     
     // Initialize components
+    BootSequence::enter(BootStage::STORAGE);
     PreferencesManager::initialize();
-    LedController::initialize();
+    TideTableStore::initialize();
     
     // Check if this is a wake from deep sleep
+    BootSequence::enter(BootStage::RESTORE);
     esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause();
     bool needsDataUpdate = true;
     
     if (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER) {
-        // Try to use saved data first
-        if (PreferencesManager::loadTideData(tideData)) {
-            time_t now = TimeService::getCurrentTime();
+        // Try to use the tide table or saved data first
+        time_t now = TimeService::getCurrentTime();
+        if (loadFromTable(now)) {
+            needsDataUpdate = false;
+        } else if (PreferencesManager::loadTideData(tideData)) {
             if (!tideData.needsUpdate(now)) {
                 needsDataUpdate = false;
             }
         }
     }
     
-    // Only connect to WiFi if we need to update data
-    if (needsDataUpdate) {
+    // Only connect to WiFi if we need to update data or the clock may have drifted too far
+    BootSequence::enter(BootStage::NETWORK);
+    bool needsTimeSync = TimeService::needsSync();
+    if (BootSequence::degraded()) {
+        // Recent boots kept failing, so show what is stored and let the loop retry slowly.
+        // The display stays dark until the clock is synced, so an unsynced clock gets
+        // one attempt, bounded by WIFI_TIMEOUT and NTP_SYNC_TIMEOUT_MS.
+        if (needsTimeSync && WiFiService::connect()) {
+            TimeService::initialize();
+            releaseWiFi();
+        }
+        if (needsDataUpdate && !TideTableStore::loadWindow(tideData, TimeService::getCurrentTime())) {
+            PreferencesManager::loadTideData(tideData);
+        }
+        backingOff = true;
+        backoffStart = TimeService::getMillis();
+    } else if (needsDataUpdate || needsTimeSync) {
         if (WiFiService::connect()) {
             TimeService::initialize();
-            tryInitialDataLoad();
-            WiFiService::disconnect();
+            if (needsDataUpdate) {
+                tryInitialDataLoad();
+            }
+            releaseWiFi();
         } else {
             // If WiFi fails, try to use saved data anyway
             PreferencesManager::loadTideData(tideData);
         }
     }
+    if (ConfigManager::get().pushMode) {
+        WiFiService::connect();  // PushService keeps retrying if this fails
+        PushService::begin(tideData);
+    }
+    EnergyMonitor::enterPhase(PowerPhase::IDLE);
+    BootSequence::finish();
 }
 
 void loop() {
     try {
         time_t now = TimeService::getCurrentTime();
+        ConfigManager::pollSerial();
+        BootSequence::checkStable();
+        bool pushMode = ConfigManager::get().pushMode;
+        if (pushMode) {
+            PushService::loop();
+        }
         
-        // Update LED display
-        LedController::updateDisplay(tideData);
+        // Update LED display, either a frame at a time or a queue of them from light sleep.
+        // Light sleep would stall the broker connection, so push mode polls.
+        if (LIGHT_SLEEP_RENDERING && !pushMode) {
+            LedController::playFrames(tideData, tideData.getNextUpdateTime());
+        } else {
+            LedController::updateDisplay(tideData);
+        }
+        if (pushMode) {
+            catchUpPush();
+        }
         
-        // Check if we need to update tide data
-        if (tideData.needsUpdate(now)) {
-            if (ENABLE_DEBUG_PRINTS) {
-                Serial.println("Tide data needs update, connecting to WiFi...");
+        // Check if we need to update tide data or resync the clock
+        bool needsTimeSync = TimeService::needsSync();
+        if (backingOff && TimeService::getMillis() - backoffStart >= DEGRADED_RETRY_INTERVAL_MS) {
+            backingOff = false;
+        }
+        if ((tideData.needsUpdate(now) || needsTimeSync) && !backingOff) {
+            if (needsTimeSync) {
+                TimeService::markSyncAttempt();
             }
-            
-            if (WiFiService::connect()) {
-                if (TideService::fetchTideData(tideData)) {
+            if (!needsTimeSync && loadFromTable(now)) {
+                if (ENABLE_DEBUG_PRINTS) {
+                    Serial.println("Tide data refreshed from tide table");
+                }
+                retryCount = 0;
+            } else if (connectForUpdate()) {
+                if (needsTimeSync) {
+                    TimeService::initialize();
+                    now = TimeService::getCurrentTime();
+                }
+                if (tideData.needsUpdate(now)) {
                     if (ENABLE_DEBUG_PRINTS) {
-                        Serial.println("Tide data updated successfully");
+                        Serial.println("Tide data needs update, connected to WiFi");
                     }
-                    PreferencesManager::saveTideData(tideData);
-                    retryCount = 0;
-                } else {
-                    if (ENABLE_DEBUG_PRINTS) {
-                        Serial.println("Failed to update tide data");
+                    if (ProvisioningService::isCheckDue(now)) {
+                        ProvisioningService::updateTables(now);
                     }
-                    if (++retryCount >= 3) {
-                        ESP.restart();
+                    if (TideTableStore::loadWindow(tideData, now)) {
+                        retryCount = 0;
+                    } else if (TideService::fetchTideData(tideData)) {
+                        if (ENABLE_DEBUG_PRINTS) {
+                            Serial.println("Tide data updated successfully");
+                        }
+                        PreferencesManager::saveTideData(tideData);
+                        printHeapStats("fetch");
+                        if (ENABLE_DEBUG_PRINTS) {
+                            EnergyMonitor::printReport();
+                        }
+                        retryCount = 0;
+                    } else {
+                        if (ENABLE_DEBUG_PRINTS) {
+                            Serial.println("Failed to update tide data");
+                        }
+                        handleFetchFailure();
                     }
                 }
-                WiFiService::disconnect();
+                releaseWiFi();
             }
         }
         
         // Only use a small delay in the loop to allow LED updates
-        delay(10); // Small delay to prevent tight loop
+        TimeService::sleep(10); // Small delay to prevent tight loop
         
     } catch (...) {
         if (ENABLE_DEBUG_PRINTS) {
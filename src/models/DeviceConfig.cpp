@@ -0,0 +1,140 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "DeviceConfig.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+enum class FieldType : uint8_t { TEXT, INT, UINT, BYTE, DOUBLE };
+
+struct FieldSpec {
+    const char* name;
+    FieldType type;
+    size_t offset;
+    double min;
+    double max;
+};
+
+// Names, types and allowed ranges; setField and isValid both check against these
+static const FieldSpec FIELDS[] = {
+    {"station", FieldType::TEXT, offsetof(DeviceConfig, stationId), 1, STATION_ID_CAPACITY},
+    {"latitude", FieldType::DOUBLE, offsetof(DeviceConfig, latitude), -90, 90},
+    {"longitude", FieldType::DOUBLE, offsetof(DeviceConfig, longitude), -180, 180},
+    {"gmt_offset", FieldType::INT, offsetof(DeviceConfig, gmtOffsetSec), -12 * 3600, 14 * 3600},
+    {"dst_offset", FieldType::INT, offsetof(DeviceConfig, daylightOffsetSec), 0, 2 * 3600},
+    {"wave_min_ms", FieldType::UINT, offsetof(DeviceConfig, minWaveIntervalMs), 1000, 3600000},
+    {"wave_max_ms", FieldType::UINT, offsetof(DeviceConfig, maxWaveIntervalMs), 1000, 3600000},
+    {"update_sec", FieldType::UINT, offsetof(DeviceConfig, updateIntervalSec), 600, 7 * 24 * 3600},
+    {"brightness", FieldType::BYTE, offsetof(DeviceConfig, brightness), 1, 255},
+    {"push", FieldType::BYTE, offsetof(DeviceConfig, pushMode), 0, 1},
+};
+static const int FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+static bool validStationId(const char* text) {
+    size_t length = strnlen(text, STATION_ID_CAPACITY + 1);
+    if (length == 0 || length > STATION_ID_CAPACITY) return false;
+    // Goes into URLs and the JSON request body unescaped
+    for (size_t i = 0; i < length; i++) {
+        if (!isalnum((unsigned char)text[i])) return false;
+    }
+    return true;
+}
+
+static double numericValue(const DeviceConfig& config, const FieldSpec& field) {
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&config) + field.offset;
+    switch (field.type) {
+        case FieldType::INT: return *reinterpret_cast<const int32_t*>(base);
+        case FieldType::UINT: return *reinterpret_cast<const uint32_t*>(base);
+        case FieldType::BYTE: return *base;
+        case FieldType::DOUBLE: return *reinterpret_cast<const double*>(base);
+        default: return 0;
+    }
+}
+
+DeviceConfig DeviceConfig::defaults() {
+    DeviceConfig config;
+    memset(&config, 0, sizeof(config));
+    config.version = VERSION;
+    config.size = sizeof(DeviceConfig);
+    strncpy(config.stationId, DEFAULT_STATION_ID, STATION_ID_CAPACITY);
+    config.latitude = DEFAULT_LATITUDE;
+    config.longitude = DEFAULT_LONGITUDE;
+    config.gmtOffsetSec = DEFAULT_GMT_OFFSET_SEC;
+    config.daylightOffsetSec = DEFAULT_DAYLIGHT_OFFSET_SEC;
+    config.minWaveIntervalMs = DEFAULT_MIN_WAVE_INTERVAL;
+    config.maxWaveIntervalMs = DEFAULT_MAX_WAVE_INTERVAL;
+    config.updateIntervalSec = DEFAULT_UPDATE_INTERVAL;
+    config.brightness = DEFAULT_BRIGHTNESS;
+    config.pushMode = DEFAULT_PUSH_MODE ? 1 : 0;
+    return config;
+}
+
+bool DeviceConfig::isValid() const {
+    if (version != VERSION || size != sizeof(DeviceConfig) || !validStationId(stationId)) {
+        return false;
+    }
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (FIELDS[i].type == FieldType::TEXT) continue;
+        double value = numericValue(*this, FIELDS[i]);
+        // Written this way round so NaN fails too
+        if (!(value >= FIELDS[i].min && value <= FIELDS[i].max)) return false;
+    }
+    return minWaveIntervalMs < maxWaveIntervalMs;
+}
+
+int DeviceConfig::fieldCount() {
+    return FIELD_COUNT;
+}
+
+const char* DeviceConfig::fieldName(int index) {
+    return index >= 0 && index < FIELD_COUNT ? FIELDS[index].name : nullptr;
+}
+
+bool DeviceConfig::formatField(int index, char* out, size_t size) const {
+    if (index < 0 || index >= FIELD_COUNT) return false;
+    const FieldSpec& field = FIELDS[index];
+    int written;
+    if (field.type == FieldType::TEXT) {
+        written = snprintf(out, size, "%s", reinterpret_cast<const char*>(this) + field.offset);
+    } else if (field.type == FieldType::DOUBLE) {
+        written = snprintf(out, size, "%.7f", numericValue(*this, field));
+    } else {
+        written = snprintf(out, size, "%ld", (long)numericValue(*this, field));
+    }
+    return written >= 0 && (size_t)written < size;
+}
+
+bool DeviceConfig::setField(const char* name, const char* value) {
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        const FieldSpec& field = FIELDS[i];
+        if (strcmp(field.name, name) != 0) continue;
+
+        uint8_t* base = reinterpret_cast<uint8_t*>(this) + field.offset;
+        if (field.type == FieldType::TEXT) {
+            if (!validStationId(value)) return false;
+            memset(base, 0, STATION_ID_CAPACITY + 1);
+            memcpy(base, value, strlen(value));
+            return true;
+        }
+
+        char* end;
+        double number = strtod(value, &end);
+        if (end == value || *end != '\0' || !(number >= field.min && number <= field.max)) {
+            return false;
+        }
+        switch (field.type) {
+            case FieldType::INT: *reinterpret_cast<int32_t*>(base) = (int32_t)number; break;
+            case FieldType::UINT: *reinterpret_cast<uint32_t*>(base) = (uint32_t)number; break;
+            case FieldType::BYTE: *base = (uint8_t)number; break;
+            case FieldType::DOUBLE: *reinterpret_cast<double*>(base) = number; break;
+            default: return false;
+        }
+        return true;
+    }
+    return false;
+}
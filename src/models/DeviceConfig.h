@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "../config/config.h"
+
+// Per-site settings, so one firmware image can serve the whole fleet. Saved
+// in NVS as a raw blob and read once at boot; hot paths read the fields
+// directly. Defaults come from platformio.ini and config.h.
+struct DeviceConfig {
+    static const uint16_t VERSION = 2;
+
+    uint16_t version;
+    uint16_t size;               // sizeof(DeviceConfig) when saved, to catch layout changes
+    char stationId[STATION_ID_CAPACITY + 1];
+    double latitude;
+    double longitude;
+    int32_t gmtOffsetSec;
+    int32_t daylightOffsetSec;
+    uint32_t minWaveIntervalMs;
+    uint32_t maxWaveIntervalMs;
+    uint32_t updateIntervalSec;
+    uint8_t brightness;
+    uint8_t pushMode;            // Stay connected for pushed updates; for mains-powered installs
+
+    static DeviceConfig defaults();
+    bool isValid() const;
+    long utcOffsetSec() const { return (long)gmtOffsetSec + daylightOffsetSec; }
+
+    // Settings addressed by name, for the serial console
+    static int fieldCount();
+    static const char* fieldName(int index);
+    bool formatField(int index, char* out, size_t size) const;
+    bool setField(const char* name, const char* value);  // False for an unknown name or bad value
+};
@@ -0,0 +1,99 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "TideBlend.h"
+#include <cmath>
+
+namespace {
+const float PI_F = 3.14159265f;
+}
+
+void TideBlend::reset(TideBlendState& state, const TideBlendParams& params) {
+    state.observedAt = 0;
+    state.offset = 0.0f;
+    state.variance = params.offsetStddev * params.offsetStddev;
+    state.observations = 0;
+}
+
+float TideBlend::predictedHeight(const TideExtreme& previous, const TideExtreme& next, time_t time) {
+    float span = (float)(next.timestamp - previous.timestamp);
+    if (span <= 0) return next.height;
+    float phase = (float)(time - previous.timestamp) / span;
+    if (phase < 0) phase = 0;
+    if (phase > 1) phase = 1;
+    float mean = (previous.height + next.height) * 0.5f;
+    float amplitude = (previous.height - next.height) * 0.5f;
+    return mean + amplitude * cosf(PI_F * phase);
+}
+
+void TideBlend::project(const TideBlendState& state, time_t time, const TideBlendParams& params,
+                        float& offset, float& variance) {
+    float stationary = params.offsetStddev * params.offsetStddev;
+    if (state.observedAt == 0) {
+        offset = 0.0f;
+        variance = stationary;
+        return;
+    }
+    float elapsed = (float)(time - state.observedAt);
+    float decay = elapsed > 0 ? expf(-elapsed / params.timeConstantSec) : 1.0f;
+    offset = state.offset * decay;
+    // Relaxes towards the stationary variance as the reading ages
+    variance = decay * decay * state.variance + stationary * (1.0f - decay * decay);
+}
+
+bool TideBlend::observe(TideBlendState& state, const TideExtreme& previous, const TideExtreme& next,
+                        time_t time, float observed, const TideBlendParams& params) {
+    if (!std::isfinite(observed) || time < state.observedAt ||
+        time < previous.timestamp || time > next.timestamp ||
+        next.timestamp - previous.timestamp > MAX_SPAN_SEC) {
+        return false;
+    }
+    float measured = observed - predictedHeight(previous, next, time);
+    if (fabsf(measured) > params.maxOffset) {
+        return false;
+    }
+
+    float offset, variance;
+    project(state, time, params, offset, variance);
+    float noise = params.observationStddev * params.observationStddev;
+    float gain = variance / (variance + noise);
+    state.offset = offset + gain * (measured - offset);
+    state.variance = (1.0f - gain) * variance;
+    state.observedAt = time;
+    if (state.observations < UINT16_MAX) {
+        state.observations++;
+    }
+    return true;
+}
+
+TideEstimate TideBlend::estimate(const TideBlendState& state, const TideExtreme& previous, const TideExtreme& next,
+                                 time_t now, const TideBlendParams& params) {
+    TideEstimate result;
+    float variance;
+    project(state, now, params, result.offset, variance);
+    result.predicted = predictedHeight(previous, next, now);
+    result.height = result.predicted + result.offset;
+    result.stddev = sqrtf(variance);
+    result.nextExtreme = next.timestamp;
+
+    // Near the extreme the curve's slope is h'' * (t - t1) and the offset's is
+    // -offset / timeConstant, so they cancel at a shift of
+    // offset / (timeConstant * h''), where h'' is amplitude * (pi / span)^2
+    float span = (float)(next.timestamp - previous.timestamp);
+    float amplitude = (previous.height - next.height) * 0.5f;
+    if (state.observedAt != 0 && span > 0 && span <= MAX_SPAN_SEC && fabsf(amplitude) >= 0.01f) {
+        float offsetAtNext, unused;
+        project(state, next.timestamp, params, offsetAtNext, unused);
+        float curvature = amplitude * PI_F * PI_F / (span * span);
+        float shift = offsetAtNext / (params.timeConstantSec * curvature);
+        // Past a quarter cycle the small-shift approximation means nothing
+        float limit = span * 0.25f;
+        if (shift > limit) shift = limit;
+        if (shift < -limit) shift = -limit;
+        result.nextExtreme = next.timestamp + (time_t)lroundf(shift);
+    }
+    return result;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include "TideTimeline.h"
+
+struct TideBlendParams {
+    float timeConstantSec;   // How quickly a surge offset dies away without new observations
+    float offsetStddev;      // Meters; typical size of the surge and wind set-up
+    float observationStddev; // Meters; noise on one gauge reading
+    float maxOffset;         // Meters; readings further than this from prediction are discarded
+};
+
+const TideBlendParams DEFAULT_BLEND_PARAMS = {
+    6 * 3600.0f,
+    0.3f,
+    0.05f,
+    3.0f,
+};
+
+// Filter state, plain so it can be copied around with TideData
+struct TideBlendState {
+    time_t observedAt;  // Time of the last accepted observation, 0 if none
+    float offset;       // Observed minus predicted at observedAt, meters
+    float variance;     // Of offset, meters squared
+    uint16_t observations;
+};
+
+struct TideEstimate {
+    float predicted;     // Height from the predicted curve alone
+    float height;        // Predicted plus the blended offset
+    float offset;
+    float stddev;        // Uncertainty of height
+    time_t nextExtreme;  // Time of the next extreme on the corrected curve
+};
+
+// Blends occasional observed water levels with the predicted curve.
+// Between two extremes the prediction is a half cosine. The observed minus
+// predicted offset is tracked by a one-state Kalman filter that models it as
+// decaying towards zero with timeConstantSec, so a stale surge reading fades
+// out instead of holding forever. Because the offset changes over time the
+// corrected curve peaks a little off the predicted extreme; nextExtreme
+// shifts by where the offset's slope cancels the curve's.
+// estimate() is a handful of float operations, cheap enough for every frame.
+// No Arduino dependencies, so recorded series can be replayed on the host.
+class TideBlend {
+public:
+    // Longest gap between a high and a low; anything wider means the
+    // previous extreme is missing
+    static const long MAX_SPAN_SEC = 18 * 3600;
+
+    static void reset(TideBlendState& state, const TideBlendParams& params = DEFAULT_BLEND_PARAMS);
+
+    // Height at time on the cosine curve from previous to next extreme
+    static float predictedHeight(const TideExtreme& previous, const TideExtreme& next, time_t time);
+
+    // Folds in a reading taken at time. Returns false if it was discarded:
+    // older than the last one, outside the extremes, between extremes too
+    // far apart, or too far off the prediction.
+    static bool observe(TideBlendState& state, const TideExtreme& previous, const TideExtreme& next,
+                        time_t time, float observed, const TideBlendParams& params = DEFAULT_BLEND_PARAMS);
+
+    static TideEstimate estimate(const TideBlendState& state, const TideExtreme& previous, const TideExtreme& next,
+                                 time_t now, const TideBlendParams& params = DEFAULT_BLEND_PARAMS);
+
+private:
+    // Propagates offset and variance from observedAt to time
+    static void project(const TideBlendState& state, time_t time, const TideBlendParams& params,
+                        float& offset, float& variance);
+};
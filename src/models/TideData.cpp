@@ -5,46 +5,77 @@
  */
 
 #include "TideData.h"
+#include "../services/TimeService.h"
+#include "../storage/ConfigManager.h"
+
+const char* tideTypeName(TideType type) {
+    switch (type) {
+        case TideType::RISING: return "RISING";
+        case TideType::FALLING: return "FALLING";
+        case TideType::HIGH_TIDE: return "HIGH";
+        case TideType::LOW_TIDE: return "LOW";
+        default: return "UNKNOWN";
+    }
+}
+
+TideType parseTideType(const char* name) {
+    if (name == nullptr) return TideType::UNKNOWN;
+    if (strcmp(name, "RISING") == 0) return TideType::RISING;
+    if (strcmp(name, "FALLING") == 0) return TideType::FALLING;
+    if (strcmp(name, "HIGH") == 0) return TideType::HIGH_TIDE;
+    if (strcmp(name, "LOW") == 0) return TideType::LOW_TIDE;
+    return TideType::UNKNOWN;
+}
 
 TideData::TideData() : 
-    type(""),
+    type(TideType::UNKNOWN),
     currentHeight(0),
-    numExtremes(0),
     lastUpdateTime(0) {
+    TideBlend::reset(blend);
 }
 
 bool TideData::hasValidFutureExtremes(time_t currentTime) const {
-    return numExtremes > 0 && currentTime < extremes[numExtremes - 1].timestamp;
+    return !extremes.empty() && currentTime < extremes.lastTimestamp();
 }
 
 bool TideData::needsUpdate(time_t currentTime) const {
-    return numExtremes == 0 ||
-           currentTime > extremes[numExtremes - 1].timestamp ||
-           (currentTime - lastUpdateTime) > UPDATE_INTERVAL;
+    return extremes.empty() ||
+           currentTime > extremes.lastTimestamp() ||
+           (currentTime - lastUpdateTime) > (time_t)ConfigManager::get().updateIntervalSec;
 }
 
 time_t TideData::getNextUpdateTime() const {
     time_t nextUpdate;
     
-    if (numExtremes == 0) {
+    if (extremes.empty()) {
         // If no data, update immediately
-        return time(nullptr);
+        return TimeService::getCurrentTime();
     }
     
     // Get time of next update based on last update time
-    time_t updateBasedOnInterval = lastUpdateTime + UPDATE_INTERVAL;
+    time_t updateBasedOnInterval = lastUpdateTime + (time_t)ConfigManager::get().updateIntervalSec;
     
     // Get time of next update based on last extreme
-    time_t updateBasedOnExtremes = extremes[numExtremes - 1].timestamp;
+    time_t updateBasedOnExtremes = extremes.lastTimestamp();
     
     // Use the earlier of the two times
     nextUpdate = min(updateBasedOnInterval, updateBasedOnExtremes);
     
     // If next update time is in the past, return current time
-    time_t currentTime = time(nullptr);
+    time_t currentTime = TimeService::getCurrentTime();
     if (nextUpdate <= currentTime) {
         return currentTime;
     }
     
     return nextUpdate;
 }
+
+bool TideData::observeLevel(time_t time, float height) {
+    currentHeight = height;
+    int nextIndex = extremes.upperBound(time);
+    if (nextIndex >= extremes.size()) {
+        return false;
+    }
+    TideExtreme previous = nextIndex > 0 ? extremes.at(nextIndex - 1) : current;
+    return TideBlend::observe(blend, previous, extremes.at(nextIndex), time, height);
+}
@@ -1,28 +1,32 @@
 #pragma once
 #include <Arduino.h>
+#include "TideTimeline.h"
+#include "TideBlend.h"
 
-// Reduce maximum number of extremes to a more reasonable size
-const int MAX_EXTREMES = 20;  // We really only need the next few extremes
-
-struct TideExtreme {
-    time_t timestamp;
-    float height;
-    bool isHigh;
+enum class TideType : uint8_t {
+    UNKNOWN,
+    RISING,
+    FALLING,
+    HIGH_TIDE,
+    LOW_TIDE
 };
 
+const char* tideTypeName(TideType type);
+TideType parseTideType(const char* name);
+
 struct TideData {
-    String type;           // RISING or FALLING
+    TideType type;         // RISING or FALLING
     float currentHeight;   // Current water level
     TideExtreme current;   // Most recent past extreme
-    TideExtreme extremes[MAX_EXTREMES];  // Store up to MAX_EXTREMES extremes
-    int numExtremes;           // Number of stored extremes
+    TideTimeline extremes; // Future extremes, up to MAX_EXTREMES
     unsigned long lastUpdateTime; // When the data was last fetched
+    TideBlendState blend;  // Observed levels folded into the predicted curve
 
     TideData();
     bool hasValidFutureExtremes(time_t currentTime) const;
     bool needsUpdate(time_t currentTime) const;
     time_t getNextUpdateTime() const;
-    
-private:
-    static const unsigned long UPDATE_INTERVAL = 6 * 3600; // 6 hours in seconds
+    // Records an observed water level and blends it with the prediction.
+    // Needs the extremes either side of time.
+    bool observeLevel(time_t time, float height);
 };
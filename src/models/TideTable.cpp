@@ -0,0 +1,305 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "TideTable.h"
+#include <cstring>
+
+namespace {
+
+void putU16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+void putU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+void putU64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+uint16_t getU16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+uint32_t getU32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+uint64_t getU64(const uint8_t* in) {
+    return (uint64_t)getU32(in) | ((uint64_t)getU32(in + 4) << 32);
+}
+
+void writeVarint(TideTableSink& sink, uint32_t value) {
+    uint8_t buffer[5];
+    size_t length = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        buffer[length++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    sink.write(buffer, length);
+}
+
+uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+}
+
+bool TideTableCodec::encodeTable(const TideTableInfo& info, const TideTableRecord* records, TideTableSink& sink) {
+    if (info.count > TIDE_TABLE_MAX_RECORDS) {
+        return false;
+    }
+
+    uint8_t header[TIDE_TABLE_HEADER_SIZE] = {};
+    putU32(header, TIDE_TABLE_MAGIC);
+    header[4] = TIDE_TABLE_VERSION;
+    memcpy(header + 8, info.stationId, TIDE_TABLE_STATION_ID_SIZE);
+    putU64(header + 20, (uint64_t)info.baseTime);
+    putU32(header + 28, info.count);
+    putU32(header + 32, info.revision);
+    sink.write(header, sizeof(header));
+
+    uint32_t previousOffset = 0;
+    int32_t previousHeight = 0;
+    for (uint32_t i = 0; i < info.count; i++) {
+        const TideTableRecord& record = records[i];
+        if (record.offset < previousOffset || record.offset - previousOffset > 0x7FFFFFFF) {
+            return false;
+        }
+        writeVarint(sink, ((record.offset - previousOffset) << 1) | (record.isHigh ? 1 : 0));
+        writeVarint(sink, zigzag(record.heightCm - previousHeight));
+        previousOffset = record.offset;
+        previousHeight = record.heightCm;
+    }
+    return true;
+}
+
+bool TideTableCodec::encodePatch(const TideTablePatchInfo& info, const TideTablePatchEntry* entries, TideTableSink& sink) {
+    if (info.count > TIDE_TABLE_MAX_PATCH_ENTRIES) {
+        return false;
+    }
+
+    uint8_t header[TIDE_TABLE_PATCH_HEADER_SIZE] = {};
+    putU32(header, TIDE_TABLE_PATCH_MAGIC);
+    header[4] = TIDE_TABLE_VERSION;
+    putU16(header + 6, info.count);
+    memcpy(header + 8, info.stationId, TIDE_TABLE_STATION_ID_SIZE);
+    putU32(header + 20, info.fromRevision);
+    putU32(header + 24, info.toRevision);
+    sink.write(header, sizeof(header));
+
+    for (uint16_t i = 0; i < info.count; i++) {
+        uint8_t entry[TIDE_TABLE_PATCH_ENTRY_SIZE] = {};
+        putU32(entry, entries[i].index);
+        putU32(entry + 4, entries[i].record.offset);
+        putU16(entry + 8, (uint16_t)entries[i].record.heightCm);
+        entry[10] = entries[i].record.isHigh ? 1 : 0;
+        sink.write(entry, sizeof(entry));
+    }
+    return true;
+}
+
+bool TideTableCodec::parsePatch(const uint8_t* data, size_t length, TideTablePatchInfo& info) {
+    if (length < TIDE_TABLE_PATCH_HEADER_SIZE + TIDE_TABLE_SIGNATURE_SIZE ||
+        getU32(data) != TIDE_TABLE_PATCH_MAGIC ||
+        data[4] != TIDE_TABLE_VERSION) {
+        return false;
+    }
+
+    info.count = getU16(data + 6);
+    memcpy(info.stationId, data + 8, TIDE_TABLE_STATION_ID_SIZE);
+    info.stationId[TIDE_TABLE_STATION_ID_SIZE - 1] = '\0';
+    info.fromRevision = getU32(data + 20);
+    info.toRevision = getU32(data + 24);
+
+    size_t expected = TIDE_TABLE_PATCH_HEADER_SIZE +
+                      (size_t)info.count * TIDE_TABLE_PATCH_ENTRY_SIZE +
+                      TIDE_TABLE_SIGNATURE_SIZE;
+    return info.count <= TIDE_TABLE_MAX_PATCH_ENTRIES &&
+           info.toRevision > info.fromRevision &&
+           length == expected;
+}
+
+TideTablePatchEntry TideTableCodec::patchEntry(const uint8_t* data, uint16_t index) {
+    const uint8_t* entry = data + TIDE_TABLE_PATCH_HEADER_SIZE + (size_t)index * TIDE_TABLE_PATCH_ENTRY_SIZE;
+    TideTablePatchEntry result;
+    result.index = getU32(entry);
+    result.record.offset = getU32(entry + 4);
+    result.record.heightCm = (int16_t)getU16(entry + 8);
+    result.record.isHigh = entry[10] ? 1 : 0;
+    result.record.reserved = 0;
+    return result;
+}
+
+void TideTableCodec::encodeLevel(const TideLevelReading& reading, TideTableSink& sink) {
+    uint8_t body[TIDE_LEVEL_BODY_SIZE] = {};
+    putU32(body, TIDE_LEVEL_MAGIC);
+    memcpy(body + 4, reading.stationId, TIDE_TABLE_STATION_ID_SIZE);
+    putU32(body + 16, reading.sequence);
+    putU32(body + 20, (uint32_t)reading.timestamp);
+    putU16(body + 24, (uint16_t)reading.heightCm);
+    sink.write(body, sizeof(body));
+}
+
+bool TideTableCodec::parseLevel(const uint8_t* data, size_t length, TideLevelReading& reading) {
+    if (length != TIDE_LEVEL_MESSAGE_SIZE || getU32(data) != TIDE_LEVEL_MAGIC) {
+        return false;
+    }
+    memcpy(reading.stationId, data + 4, TIDE_TABLE_STATION_ID_SIZE);
+    reading.stationId[TIDE_TABLE_STATION_ID_SIZE - 1] = '\0';
+    reading.sequence = getU32(data + 16);
+    reading.timestamp = getU32(data + 20);
+    reading.heightCm = (int16_t)getU16(data + 24);
+    return true;
+}
+
+bool TideTableCodec::setStationId(char (&dest)[TIDE_TABLE_STATION_ID_SIZE], const char* stationId) {
+    memset(dest, 0, sizeof(dest));
+    size_t length = strlen(stationId);
+    if (length >= sizeof(dest)) {
+        return false;
+    }
+    memcpy(dest, stationId, length);
+    return true;
+}
+
+bool TideTableCodec::sameStation(const char* a, const char* b) {
+    return strncmp(a, b, TIDE_TABLE_STATION_ID_SIZE) == 0;
+}
+
+TideTableDecoder::TideTableDecoder(Listener& listener) :
+    _listener(listener),
+    _state(HEADER),
+    _filled(0),
+    _count(0),
+    _recordsDecoded(0),
+    _varint(0),
+    _varintShift(0),
+    _timeField(0),
+    _offset(0),
+    _heightCm(0) {
+}
+
+bool TideTableDecoder::feed(const uint8_t* data, size_t length) {
+    size_t signedStart = 0;
+    for (size_t i = 0; i < length; i++) {
+        bool wasSigned = _state < SIGNATURE;
+        if (!consume(data[i])) {
+            _state = FAILED;
+            return false;
+        }
+        if (wasSigned && _state >= SIGNATURE) {
+            // This byte finished the signed part of the stream
+            _listener.onSignedBytes(data + signedStart, i + 1 - signedStart);
+            signedStart = length;
+        }
+    }
+    if (_state < SIGNATURE && signedStart < length) {
+        _listener.onSignedBytes(data + signedStart, length - signedStart);
+    }
+    return true;
+}
+
+bool TideTableDecoder::consume(uint8_t byte) {
+    bool complete = false;
+    switch (_state) {
+        case HEADER:
+            _header[_filled++] = byte;
+            return _filled < TIDE_TABLE_HEADER_SIZE || finishHeader();
+
+        case RECORD_TIME:
+            if (!readVarint(byte, complete)) {
+                return false;
+            }
+            if (complete) {
+                _timeField = _varint;
+                _state = RECORD_HEIGHT;
+            }
+            return true;
+
+        case RECORD_HEIGHT:
+            if (!readVarint(byte, complete)) {
+                return false;
+            }
+            return !complete || finishRecord(_varint);
+
+        case SIGNATURE:
+            _signature[_filled++] = byte;
+            if (_filled == TIDE_TABLE_SIGNATURE_SIZE) {
+                _state = DONE;
+            }
+            return true;
+
+        default:
+            return false;  // Trailing bytes after the signature, or already failed
+    }
+}
+
+bool TideTableDecoder::finishHeader() {
+    if (getU32(_header) != TIDE_TABLE_MAGIC || _header[4] != TIDE_TABLE_VERSION) {
+        return false;
+    }
+
+    TideTableInfo info;
+    memcpy(info.stationId, _header + 8, TIDE_TABLE_STATION_ID_SIZE);
+    info.stationId[TIDE_TABLE_STATION_ID_SIZE - 1] = '\0';
+    info.baseTime = (int64_t)getU64(_header + 20);
+    info.count = getU32(_header + 28);
+    info.revision = getU32(_header + 32);
+    if (info.count > TIDE_TABLE_MAX_RECORDS || !_listener.onHeader(info)) {
+        return false;
+    }
+
+    _count = info.count;
+    _filled = 0;
+    _state = _count > 0 ? RECORD_TIME : SIGNATURE;
+    return true;
+}
+
+bool TideTableDecoder::readVarint(uint8_t byte, bool& complete) {
+    if (_varintShift == 0) {
+        _varint = 0;
+    }
+    if (_varintShift > 28 || (_varintShift == 28 && (byte & 0x70))) {
+        return false;  // Longer than 32 bits
+    }
+    _varint |= (uint32_t)(byte & 0x7F) << _varintShift;
+    complete = (byte & 0x80) == 0;
+    _varintShift = complete ? 0 : _varintShift + 7;
+    return true;
+}
+
+bool TideTableDecoder::finishRecord(uint32_t heightField) {
+    _offset += _timeField >> 1;
+    _heightCm += unzigzag(heightField);
+    if (_offset > UINT32_MAX || _heightCm < INT16_MIN || _heightCm > INT16_MAX) {
+        return false;
+    }
+
+    TideTableRecord record;
+    record.offset = (uint32_t)_offset;
+    record.heightCm = (int16_t)_heightCm;
+    record.isHigh = _timeField & 1;
+    record.reserved = 0;
+    if (!_listener.onRecord(record)) {
+        return false;
+    }
+
+    _recordsDecoded++;
+    _state = _recordsDecoded < _count ? RECORD_TIME : SIGNATURE;
+    return true;
+}
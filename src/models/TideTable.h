@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Binary tide tables: a year or more of extremes for one station, provisioned
+// in a single download and kept current with small signed patches. This file
+// has no Arduino dependencies so tools/tidetable can share it.
+//
+// Table stream, as downloaded (little-endian):
+//   header     36 bytes, see TIDE_TABLE_HEADER_SIZE
+//   records    per extreme: varint((seconds since previous << 1) | isHigh),
+//              varint(zigzag(centimeters - previous centimeters))
+//   signature  ECDSA P-256 over SHA-256 of header and records, r then s
+//
+// Patch:
+//   header     32 bytes, see TIDE_TABLE_PATCH_HEADER_SIZE
+//   entries    12 bytes each: index, offset, heightCm, isHigh, reserved
+//   signature  The same, over header and entries
+//
+// Level reading, pushed when the observed water level moves:
+//   body       32 bytes: magic, station id, sequence, timestamp, centimeters,
+//              reserved. The sequence rises with every reading published for
+//              the station, so a captured message can't be replayed.
+//   signature  The same, over the body
+//
+// Devices hold only the public key, TIDE_TABLE_PUBLIC_KEY in
+// wifi_credentials.h; the private key stays with whoever builds the tables.
+//
+// The stream is delta coded instead of run through a general-purpose
+// compressor: extremes shrink to about 5 bytes each and decoding needs a few
+// bytes of state rather than a 32 KB dictionary.
+
+const uint32_t TIDE_TABLE_MAGIC = 0x54444954;        // "TIDT"
+const uint32_t TIDE_TABLE_PATCH_MAGIC = 0x50444954;  // "TIDP"
+const uint32_t TIDE_LEVEL_MAGIC = 0x4C444954;        // "TIDL"
+const uint8_t TIDE_TABLE_VERSION = 2;                // 1 was signed with a shared HMAC key
+const size_t TIDE_TABLE_HEADER_SIZE = 36;
+const size_t TIDE_TABLE_PATCH_HEADER_SIZE = 32;
+const size_t TIDE_TABLE_PATCH_ENTRY_SIZE = 12;
+const size_t TIDE_TABLE_SIGNATURE_SIZE = 64;
+const size_t TIDE_TABLE_DIGEST_SIZE = 32;            // SHA-256, which the signature is over
+const size_t TIDE_TABLE_PUBLIC_KEY_SIZE = 65;        // Uncompressed P-256 point
+const size_t TIDE_TABLE_STATION_ID_SIZE = 12;
+const size_t TIDE_LEVEL_BODY_SIZE = 32;
+const size_t TIDE_LEVEL_MESSAGE_SIZE = TIDE_LEVEL_BODY_SIZE + TIDE_TABLE_SIGNATURE_SIZE;
+const uint32_t TIDE_TABLE_MAX_RECORDS = 8192;        // Over five years of extremes
+const uint16_t TIDE_TABLE_MAX_PATCH_ENTRIES = 256;
+
+struct TideTableInfo {
+    char stationId[TIDE_TABLE_STATION_ID_SIZE];  // NUL padded
+    int64_t baseTime;                            // Epoch seconds that record offsets count from
+    uint32_t count;
+    uint32_t revision;                           // Raised by every patch
+};
+
+struct TideTableRecord {
+    uint32_t offset;   // Seconds after baseTime
+    int16_t heightCm;
+    uint8_t isHigh;
+    uint8_t reserved;
+};
+
+struct TideTablePatchInfo {
+    char stationId[TIDE_TABLE_STATION_ID_SIZE];
+    uint32_t fromRevision;
+    uint32_t toRevision;
+    uint16_t count;
+};
+
+struct TideTablePatchEntry {
+    uint32_t index;    // Record to replace; the table's count appends
+    TideTableRecord record;
+};
+
+struct TideLevelReading {
+    char stationId[TIDE_TABLE_STATION_ID_SIZE];  // NUL padded
+    uint32_t sequence;
+    int64_t timestamp;  // When the level was observed, epoch seconds
+    int16_t heightCm;
+};
+
+class TideTableSink {
+public:
+    virtual ~TideTableSink() {}
+    virtual void write(const uint8_t* data, size_t length) = 0;
+};
+
+class TideTableCodec {
+public:
+    // Write the unsigned table stream or patch; the caller appends the signature.
+    // Records must be in time order.
+    static bool encodeTable(const TideTableInfo& info, const TideTableRecord* records, TideTableSink& sink);
+    static bool encodePatch(const TideTablePatchInfo& info, const TideTablePatchEntry* entries, TideTableSink& sink);
+
+    // Parses a whole patch held in memory. The signature is the last
+    // TIDE_TABLE_SIGNATURE_SIZE bytes and covers everything before it.
+    static bool parsePatch(const uint8_t* data, size_t length, TideTablePatchInfo& info);
+    static TideTablePatchEntry patchEntry(const uint8_t* data, uint16_t index);
+
+    // Level readings are unsigned on the way in and checked as a whole message
+    static void encodeLevel(const TideLevelReading& reading, TideTableSink& sink);
+    static bool parseLevel(const uint8_t* data, size_t length, TideLevelReading& reading);
+
+    static bool setStationId(char (&dest)[TIDE_TABLE_STATION_ID_SIZE], const char* stationId);
+    static bool sameStation(const char* a, const char* b);
+};
+
+// Decodes a table stream as it arrives, in chunks of any size, using a fixed
+// amount of memory.
+class TideTableDecoder {
+public:
+    class Listener {
+    public:
+        virtual ~Listener() {}
+        virtual void onSignedBytes(const uint8_t* data, size_t length) = 0;  // Feed to the digest
+        virtual bool onHeader(const TideTableInfo& info) = 0;
+        virtual bool onRecord(const TideTableRecord& record) = 0;
+    };
+
+    explicit TideTableDecoder(Listener& listener);
+
+    bool feed(const uint8_t* data, size_t length);  // False once the stream is malformed or refused
+    bool finished() const { return _state == DONE; }
+    const uint8_t* signature() const { return _signature; }
+    uint32_t recordsDecoded() const { return _recordsDecoded; }
+
+private:
+    enum State { HEADER, RECORD_TIME, RECORD_HEIGHT, SIGNATURE, DONE, FAILED };
+
+    bool consume(uint8_t byte);
+    bool finishHeader();
+    bool readVarint(uint8_t byte, bool& complete);
+    bool finishRecord(uint32_t heightField);
+
+    Listener& _listener;
+    State _state;
+    uint8_t _header[TIDE_TABLE_HEADER_SIZE];
+    size_t _filled;
+    uint32_t _count;
+    uint32_t _recordsDecoded;
+    uint32_t _varint;
+    uint8_t _varintShift;
+    uint32_t _timeField;
+    uint64_t _offset;
+    int32_t _heightCm;
+    uint8_t _signature[TIDE_TABLE_SIGNATURE_SIZE];
+};
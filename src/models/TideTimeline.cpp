@@ -0,0 +1,13 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "TideTimeline.h"
+
+static uint32_t revisionCounter = 0;
+
+uint32_t nextTimelineRevision() {
+    return ++revisionCounter;
+}
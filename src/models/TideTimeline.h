@@ -0,0 +1,178 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+// About one response's worth of future extremes, in less RAM than the
+// 20 padded TideExtremes this used to hold
+const int MAX_EXTREMES = 24;
+
+struct TideExtreme {
+    time_t timestamp;
+    float height;
+    bool isHigh;
+};
+
+// Shared by every timeline, whatever its capacity, so a copied-in timeline
+// never matches a stale cursor
+uint32_t nextTimelineRevision();
+
+// Tide extremes stored as parallel arrays: 32-bit second offsets from a base
+// time, heights in centimeters and a bitset of high/low flags. Six and a bit
+// bytes per extreme instead of a padded 16-byte TideExtreme.
+// Extremes must be added in ascending time order.
+template <int Capacity>
+class BasicTideTimeline {
+public:
+    static const int CAPACITY = Capacity;
+    static_assert(Capacity > 0 && Capacity <= UINT16_MAX, "count is 16 bits");
+
+    BasicTideTimeline() { clear(); }
+
+    void clear();
+    bool push(time_t timestamp, float height, bool isHigh);
+    bool push(const TideExtreme& extreme) { return push(extreme.timestamp, extreme.height, extreme.isHigh); }
+
+    int size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    bool full() const { return _count >= CAPACITY; }
+    uint32_t revision() const { return _revision; }
+
+    time_t timestamp(int index) const { return _base + (time_t)_offsets[index]; }
+    float height(int index) const { return _heights[index] / 100.0f; }
+    bool isHigh(int index) const { return (_highBits[index >> 5] >> (index & 31)) & 1; }
+    TideExtreme at(int index) const;
+    time_t lastTimestamp() const { return timestamp(_count - 1); }
+
+    // Index of the first extreme at or after / strictly after the given time,
+    // or size() if there is none. O(log n) with no data-dependent branches.
+    int lowerBound(time_t time) const;
+    int upperBound(time_t time) const;
+
+    // Remembers its position so that repeated lookups with a clock that only
+    // moves forward cost amortized O(1). Falls back to a binary search when
+    // time goes backwards or the timeline has been rebuilt.
+    class Cursor {
+    public:
+        Cursor() : _index(0), _lastTime(0), _revision(0) {}
+        int next(const BasicTideTimeline& timeline, time_t now);  // Same as upperBound(now)
+        void reset() { _revision = 0; }
+
+    private:
+        int _index;
+        time_t _lastTime;
+        uint32_t _revision;
+    };
+
+private:
+    uint32_t keyFor(time_t time) const;
+
+    time_t _base;
+    uint32_t _offsets[CAPACITY];
+    int16_t _heights[CAPACITY];
+    uint32_t _highBits[(CAPACITY + 31) / 32];
+    uint16_t _count;
+    uint32_t _revision;  // Changes on every edit so cursors can detect stale positions
+};
+
+typedef BasicTideTimeline<MAX_EXTREMES> TideTimeline;
+
+template <int Capacity>
+void BasicTideTimeline<Capacity>::clear() {
+    _base = 0;
+    _count = 0;
+    memset(_highBits, 0, sizeof(_highBits));
+    _revision = nextTimelineRevision();
+}
+
+template <int Capacity>
+bool BasicTideTimeline<Capacity>::push(time_t timestamp, float height, bool isHigh) {
+    if (full()) {
+        return false;
+    }
+    if (_count == 0) {
+        _base = timestamp;
+    } else if (timestamp < lastTimestamp() || (uint64_t)(timestamp - _base) > UINT32_MAX) {
+        return false;
+    }
+
+    float centimeters = roundf(height * 100.0f);
+    if (!(centimeters >= INT16_MIN && centimeters <= INT16_MAX)) {
+        return false;
+    }
+
+    _offsets[_count] = (uint32_t)(timestamp - _base);
+    _heights[_count] = (int16_t)centimeters;
+    if (isHigh) {
+        _highBits[_count >> 5] |= 1u << (_count & 31);
+    }
+    _count++;
+    _revision = nextTimelineRevision();
+    return true;
+}
+
+template <int Capacity>
+TideExtreme BasicTideTimeline<Capacity>::at(int index) const {
+    TideExtreme extreme;
+    extreme.timestamp = timestamp(index);
+    extreme.height = height(index);
+    extreme.isHigh = isHigh(index);
+    return extreme;
+}
+
+template <int Capacity>
+uint32_t BasicTideTimeline<Capacity>::keyFor(time_t time) const {
+    // Saturate into the offset range so times outside the timeline still compare correctly
+    if (time <= _base) {
+        return 0;
+    }
+    uint64_t offset = (uint64_t)(time - _base);
+    return offset > UINT32_MAX ? UINT32_MAX : (uint32_t)offset;
+}
+
+template <int Capacity>
+int BasicTideTimeline<Capacity>::lowerBound(time_t time) const {
+    if (_count == 0) {
+        return 0;
+    }
+    uint32_t key = keyFor(time);
+
+    // Halve the range each step; the select compiles to a conditional move
+    const uint32_t* first = _offsets;
+    int length = _count;
+    while (length > 1) {
+        int half = length / 2;
+        first = (first[half] < key) ? first + half : first;
+        length -= half;
+    }
+    return (int)(first - _offsets) + (*first < key);
+}
+
+template <int Capacity>
+int BasicTideTimeline<Capacity>::upperBound(time_t time) const {
+    if (_count == 0) {
+        return 0;
+    }
+    if (time < _base) {
+        return 0;
+    }
+    if ((uint64_t)(time - _base) >= UINT32_MAX) {
+        return _count;
+    }
+    return lowerBound(time + 1);
+}
+
+template <int Capacity>
+int BasicTideTimeline<Capacity>::Cursor::next(const BasicTideTimeline& timeline, time_t now) {
+    if (_revision != timeline.revision() || now < _lastTime) {
+        _index = timeline.upperBound(now);
+        _revision = timeline.revision();
+    } else {
+        while (_index < timeline.size() && timeline.timestamp(_index) <= now) {
+            _index++;
+        }
+    }
+    _lastTime = now;
+    return _index;
+}
@@ -0,0 +1,137 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "TideValidator.h"
+#include <cmath>
+
+void TideCandidates::add(time_t timestamp, float height, bool isHigh) {
+    if (count >= MAX_CANDIDATE_EXTREMES) {
+        overflow = true;
+        return;
+    }
+    items[count++] = {timestamp, height, isHigh};
+}
+
+const char* tideCheckName(TideCheck check) {
+    switch (check) {
+        case TideCheck::OK: return "ok";
+        case TideCheck::TOO_MANY: return "too many extremes";
+        case TideCheck::BAD_VALUE: return "bad value";
+        case TideCheck::HEIGHT_RANGE: return "height out of range";
+        case TideCheck::ALTERNATION: return "highs and lows out of order";
+        case TideCheck::SPACING: return "extremes too close or too far apart";
+        case TideCheck::HORIZON: return "does not cover now and the day ahead";
+        default: return "unknown";
+    }
+}
+
+namespace {
+
+typedef TideCheck (*ValidationStep)(TideCandidates&, time_t, const TideValidationLimits&);
+
+TideCheck checkValues(TideCandidates& c, time_t, const TideValidationLimits&) {
+    if (c.overflow) return TideCheck::TOO_MANY;
+    for (int i = 0; i < c.count; i++) {
+        if (c.items[i].timestamp <= 0 || !std::isfinite(c.items[i].height)) {
+            return TideCheck::BAD_VALUE;
+        }
+    }
+    return TideCheck::OK;
+}
+
+TideCheck sortByTime(TideCandidates& c, time_t, const TideValidationLimits&) {
+    // Insertion sort: stable, in place, and the input is normally sorted already
+    for (int i = 1; i < c.count; i++) {
+        TideExtreme item = c.items[i];
+        int j = i - 1;
+        while (j >= 0 && c.items[j].timestamp > item.timestamp) {
+            c.items[j + 1] = c.items[j];
+            j--;
+        }
+        c.items[j + 1] = item;
+    }
+    return TideCheck::OK;
+}
+
+TideCheck dropDuplicates(TideCandidates& c, time_t, const TideValidationLimits& limits) {
+    int kept = 0;
+    for (int i = 0; i < c.count; i++) {
+        if (kept > 0 &&
+            c.items[kept - 1].isHigh == c.items[i].isHigh &&
+            c.items[i].timestamp - c.items[kept - 1].timestamp < limits.duplicateWindowSec) {
+            continue;
+        }
+        c.items[kept++] = c.items[i];
+    }
+    c.count = kept;
+    return TideCheck::OK;
+}
+
+TideCheck checkHeights(TideCandidates& c, time_t, const TideValidationLimits& limits) {
+    for (int i = 0; i < c.count; i++) {
+        if (c.items[i].height < limits.minHeight || c.items[i].height > limits.maxHeight) {
+            return TideCheck::HEIGHT_RANGE;
+        }
+    }
+    return TideCheck::OK;
+}
+
+TideCheck checkAlternation(TideCandidates& c, time_t, const TideValidationLimits&) {
+    for (int i = 1; i < c.count; i++) {
+        const TideExtreme& previous = c.items[i - 1];
+        const TideExtreme& current = c.items[i];
+        if (current.isHigh == previous.isHigh) {
+            return TideCheck::ALTERNATION;
+        }
+        // A high has to be above the lows either side of it
+        if (current.isHigh ? current.height <= previous.height : current.height >= previous.height) {
+            return TideCheck::ALTERNATION;
+        }
+    }
+    return TideCheck::OK;
+}
+
+TideCheck checkSpacing(TideCandidates& c, time_t, const TideValidationLimits& limits) {
+    // Also makes timestamps strictly increasing, since minSpacingSec is positive
+    for (int i = 1; i < c.count; i++) {
+        time_t gap = c.items[i].timestamp - c.items[i - 1].timestamp;
+        if (gap < limits.minSpacingSec || gap > limits.maxSpacingSec) {
+            return TideCheck::SPACING;
+        }
+    }
+    return TideCheck::OK;
+}
+
+TideCheck checkHorizon(TideCandidates& c, time_t now, const TideValidationLimits& limits) {
+    // The display needs the extreme before now as well as the ones after it
+    if (c.count < 2 || c.items[0].timestamp > now ||
+        c.items[c.count - 1].timestamp < now + limits.minHorizonSec) {
+        return TideCheck::HORIZON;
+    }
+    return TideCheck::OK;
+}
+
+const ValidationStep STEPS[] = {
+    checkValues,
+    sortByTime,
+    dropDuplicates,
+    checkHeights,
+    checkAlternation,
+    checkSpacing,
+    checkHorizon,
+};
+
+}  // namespace
+
+TideCheck TideValidator::validate(TideCandidates& candidates, time_t now, const TideValidationLimits& limits) {
+    for (ValidationStep step : STEPS) {
+        TideCheck result = step(candidates, now, limits);
+        if (result != TideCheck::OK) {
+            return result;
+        }
+    }
+    return TideCheck::OK;
+}
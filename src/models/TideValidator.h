@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include "TideTimeline.h"
+
+// Room for every extreme in one response: a day back and five ahead is
+// about 24, so this leaves slack for duplicates before they are dropped
+const int MAX_CANDIDATE_EXTREMES = 48;
+
+// Extremes as they came from the server, before validation
+struct TideCandidates {
+    TideExtreme items[MAX_CANDIDATE_EXTREMES];
+    int count;
+    bool overflow;  // The response had more extremes than fit
+
+    void clear() { count = 0; overflow = false; }
+    void add(time_t timestamp, float height, bool isHigh);
+};
+
+struct TideValidationLimits {
+    float minHeight;          // Meters; beyond these the datum or units are wrong
+    float maxHeight;
+    long duplicateWindowSec;  // Same-type extremes closer than this are one extreme
+    long minSpacingSec;       // Real high/low pairs are never closer than this
+    long maxSpacingSec;       // Nor further apart, even at diurnal stations
+    long minHorizonSec;       // Must cover at least this far ahead of now
+};
+
+const TideValidationLimits DEFAULT_VALIDATION_LIMITS = {
+    -5.0f, 20.0f,
+    15 * 60,
+    60 * 60,
+    18 * 3600,
+    24 * 3600,
+};
+
+enum class TideCheck : uint8_t {
+    OK,
+    TOO_MANY,
+    BAD_VALUE,
+    HEIGHT_RANGE,
+    ALTERNATION,
+    SPACING,
+    HORIZON
+};
+
+const char* tideCheckName(TideCheck check);
+
+// Cleans up and checks a set of extremes before it is allowed to replace
+// good data: sorts by time, drops duplicates, then rejects the set if any
+// height, high/low order, spacing or coverage check fails. The steps run
+// from a table in order and work in place, with no allocation.
+class TideValidator {
+public:
+    static TideCheck validate(TideCandidates& candidates, time_t now,
+                              const TideValidationLimits& limits = DEFAULT_VALIDATION_LIMITS);
+};
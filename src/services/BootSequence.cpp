@@ -0,0 +1,177 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "BootSequence.h"
+#include <esp_system.h>
+
+namespace {
+
+const uint32_t RECORD_MAGIC = 0x424F4F32;  // "BOO2"; changed with the layout
+
+struct BootRecord {
+    uint32_t magic;
+    uint32_t bootCount;
+    uint8_t stage;           // Furthest stage of the current boot, so a crash can be placed
+    uint8_t failedBoots;     // Consecutive boots that ended before they were stable
+    uint8_t lastFailedStage;
+    uint8_t resetReason;     // Why this boot happened
+    bool stable;             // This boot has run long enough, or restarted on purpose
+    uint8_t slowPixelBoots;  // Boots whose cached first pixel missed FIRST_PIXEL_BUDGET_MS
+};
+
+RTC_DATA_ATTR BootRecord record;
+
+}
+
+unsigned long BootSequence::stageMicros[(int)BootStage::COUNT];
+BootStage BootSequence::currentStage = BootStage::START;
+unsigned long BootSequence::stageStartMicros = 0;
+unsigned long BootSequence::firstPixelMicros = 0;
+bool BootSequence::firstPixelCached = false;
+bool BootSequence::degradedMode = false;
+
+void BootSequence::begin() {
+    stageStartMicros = micros();
+    esp_reset_reason_t reason = esp_reset_reason();
+    if (record.magic != RECORD_MAGIC) {
+        memset(&record, 0, sizeof(record));
+        record.magic = RECORD_MAGIC;
+        record.stable = true;
+    }
+
+    // Waking from deep sleep is how a good cycle ends, and the reset pin isn't a crash
+    if (!record.stable && reason != ESP_RST_DEEPSLEEP && reason != ESP_RST_EXT) {
+        if (record.failedBoots < UINT8_MAX) {
+            record.failedBoots++;
+        }
+        record.lastFailedStage = record.stage;
+    }
+    degradedMode = record.failedBoots >= BOOT_FAILURE_LIMIT;
+
+    record.bootCount++;
+    record.resetReason = (uint8_t)reason;
+    record.stage = (uint8_t)BootStage::START;
+    record.stable = false;
+    currentStage = BootStage::START;
+    firstPixelMicros = 0;
+    firstPixelCached = false;
+    memset(stageMicros, 0, sizeof(stageMicros));
+}
+
+void BootSequence::enter(BootStage stage) {
+    unsigned long now = micros();
+    stageMicros[(int)currentStage] += now - stageStartMicros;
+    stageStartMicros = now;
+    currentStage = stage;
+    record.stage = (uint8_t)stage;
+}
+
+void BootSequence::finish() {
+    enter(BootStage::READY);
+    if (ENABLE_DEBUG_PRINTS) {
+        printTimeline();
+    } else if (ENABLE_ERROR_PRINTS && overPixelBudget()) {
+        // Printed here rather than when the pixel is shown, so a slow serial port can't add to it
+        Serial.printf("First pixel at %lu ms, over the %lu ms budget (%u boots so far)\n",
+            firstPixelMicros / 1000, FIRST_PIXEL_BUDGET_MS, (unsigned)record.slowPixelBoots);
+    }
+}
+
+void BootSequence::markFirstPixel() {
+    if (firstPixelMicros != 0) return;
+    firstPixelMicros = micros();
+    // Only the frame from the RTC cache is budgeted; without one the first
+    // pixel waits for data
+    if (currentStage != BootStage::FIRST_PIXEL) return;
+    firstPixelCached = true;
+    if (overPixelBudget() && record.slowPixelBoots < UINT8_MAX) {
+        record.slowPixelBoots++;
+    }
+}
+
+bool BootSequence::overPixelBudget() {
+    return firstPixelCached && firstPixelMicros / 1000 > FIRST_PIXEL_BUDGET_MS;
+}
+
+void BootSequence::checkStable() {
+    if (record.stable || millis() < BOOT_STABLE_MS) return;
+    record.stable = true;
+    record.failedBoots = 0;
+    if (ENABLE_DEBUG_PRINTS && degradedMode) {
+        Serial.println("Boot stable; the next boot will be normal");
+    }
+}
+
+void BootSequence::recover(const char* reason) {
+    if (degradedMode) {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.printf("%s failed; degraded mode, not restarting\n", reason);
+        }
+        return;
+    }
+    if (ENABLE_ERROR_PRINTS) {
+        Serial.printf("%s failed, restarting...\n", reason);
+    }
+    delay(100);  // Let the message out
+    ESP.restart();
+}
+
+void BootSequence::restart() {
+    record.stable = true;
+    ESP.restart();
+}
+
+void BootSequence::printTimeline() {
+    Serial.printf("Boot #%lu (%s), %u failed boots before it%s\n",
+        (unsigned long)record.bootCount, resetReasonName(record.resetReason), record.failedBoots,
+        degradedMode ? ", DEGRADED" : "");
+    if (record.failedBoots > 0) {
+        Serial.printf("  last failed boot ended in %s\n", stageName((BootStage)record.lastFailedStage));
+    }
+    unsigned long totalMicros = 0;
+    for (int i = 0; i < (int)BootStage::READY; i++) {
+        Serial.printf("  %-12s %8.1f ms\n", stageName((BootStage)i), stageMicros[i] / 1000.0f);
+        totalMicros += stageMicros[i];
+    }
+    Serial.printf("  %-12s %8.1f ms\n", "setup", totalMicros / 1000.0f);
+    if (firstPixelMicros != 0) {
+        Serial.printf("  first pixel at %lu ms since reset (budget %lu ms%s), %u boots over budget\n",
+            firstPixelMicros / 1000, FIRST_PIXEL_BUDGET_MS, overPixelBudget() ? ", OVER" : "",
+            (unsigned)record.slowPixelBoots);
+    } else {
+        Serial.println("  no pixel yet: nothing cached to show");
+    }
+}
+
+const char* BootSequence::stageName(BootStage stage) {
+    switch (stage) {
+        case BootStage::START: return "start";
+        case BootStage::CONFIG: return "config";
+        case BootStage::FIRST_PIXEL: return "first pixel";
+        case BootStage::SERIAL_WAIT: return "serial wait";
+        case BootStage::PROG_CHECK: return "prog check";
+        case BootStage::STORAGE: return "storage";
+        case BootStage::RESTORE: return "restore";
+        case BootStage::NETWORK: return "network";
+        case BootStage::READY: return "ready";
+        default: return "unknown";
+    }
+}
+
+const char* BootSequence::resetReasonName(uint8_t reason) {
+    switch ((esp_reset_reason_t)reason) {
+        case ESP_RST_POWERON: return "power on";
+        case ESP_RST_EXT: return "reset pin";
+        case ESP_RST_SW: return "restart";
+        case ESP_RST_PANIC: return "panic";
+        case ESP_RST_INT_WDT: return "interrupt watchdog";
+        case ESP_RST_TASK_WDT: return "task watchdog";
+        case ESP_RST_WDT: return "watchdog";
+        case ESP_RST_DEEPSLEEP: return "deep sleep wake";
+        case ESP_RST_BROWNOUT: return "brownout";
+        default: return "unknown";
+    }
+}
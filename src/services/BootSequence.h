@@ -0,0 +1,57 @@
+#pragma once
+#include <Arduino.h>
+#include "../config/config.h"
+
+// Steps of setup(), in the order they run
+enum class BootStage : uint8_t {
+    START,
+    CONFIG,
+    FIRST_PIXEL,  // LED init and a frame from the RTC cache
+    SERIAL_WAIT,
+    PROG_CHECK,
+    STORAGE,
+    RESTORE,      // Tide data from the table or NVS
+    NETWORK,      // WiFi, NTP and fetching
+    READY,        // setup() has returned
+    COUNT
+};
+
+// Times each stage of setup() and keeps a boot record in RTC memory, which
+// survives panics, watchdog resets and deep sleep. A boot that ends before it
+// has run for BOOT_STABLE_MS counts as failed, and after BOOT_FAILURE_LIMIT
+// of those in a row the device boots degraded: no network at boot beyond
+// one time sync when the clock needs it, and failures back off instead of
+// restarting again. A first pixel from the RTC cache later than
+// FIRST_PIXEL_BUDGET_MS is counted in the boot record and reported at the end
+// of setup() at the error log level, so release builds show it too; nothing
+// is skipped to meet it.
+class BootSequence {
+public:
+    static void begin();                  // First thing in setup()
+    static void enter(BootStage stage);   // Ends the current stage's timing
+    static void finish();                 // End of setup(); prints the timeline
+    static void markFirstPixel();         // Called for every frame; only the first counts
+    static void checkStable();            // From loop(); clears the failure count once up long enough
+
+    static bool degraded() { return degradedMode; }
+
+    // Restart to get out of a failure, unless restarts have stopped helping.
+    // Returns only in degraded mode.
+    static void recover(const char* reason);
+    // Deliberate restart, e.g. to apply a new config; not counted as a failure
+    static void restart();
+
+    static void printTimeline();
+
+private:
+    static bool overPixelBudget();  // This boot's first pixel came later than FIRST_PIXEL_BUDGET_MS
+    static const char* stageName(BootStage stage);
+    static const char* resetReasonName(uint8_t reason);
+
+    static unsigned long stageMicros[(int)BootStage::COUNT];
+    static BootStage currentStage;
+    static unsigned long stageStartMicros;
+    static unsigned long firstPixelMicros;
+    static bool firstPixelCached;  // The first pixel came from the RTC cache, so the budget applies
+    static bool degradedMode;
+};
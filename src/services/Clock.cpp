@@ -0,0 +1,39 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "Clock.h"
+#include <esp_sleep.h>
+
+void SystemClock::lightSleep(unsigned long ms) {
+    // Timer wakeup; millis() keeps counting through light sleep
+    if (esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000) != ESP_OK ||
+        esp_light_sleep_start() != ESP_OK) {
+        delay(ms);
+    }
+}
+
+VirtualClock::VirtualClock(time_t startTime, unsigned long speedup) :
+    _startTime(startTime),
+    _speedup(speedup),
+    _elapsedMs(0),
+    _sleptMs(0) {
+}
+
+time_t VirtualClock::now() {
+    return _startTime + (time_t)(_elapsedMs / 1000);
+}
+
+unsigned long VirtualClock::millis() {
+    return (unsigned long)_elapsedMs;
+}
+
+void VirtualClock::sleep(unsigned long ms) {
+    _elapsedMs += ms;
+    _sleptMs += ms;
+    if (_speedup > 0 && ms >= _speedup) {
+        delay(ms / _speedup);
+    }
+}
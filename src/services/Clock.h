@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include "time.h"
+
+// Source of wall-clock time, uptime and delays. Everything that needs the
+// time goes through TimeService, which holds the active clock.
+class Clock {
+public:
+    virtual ~Clock() {}
+    virtual time_t now() = 0;                  // Wall-clock seconds since epoch
+    virtual unsigned long millis() = 0;        // Milliseconds since boot
+    virtual void sleep(unsigned long ms) = 0;  // Block for ms of this clock's time
+    // Like sleep, but the CPU may be suspended; peripherals keep their state
+    virtual void lightSleep(unsigned long ms) { sleep(ms); }
+};
+
+class SystemClock : public Clock {
+public:
+    time_t now() override { return time(nullptr); }
+    unsigned long millis() override { return ::millis(); }
+    void sleep(unsigned long ms) override { delay(ms); }
+    void lightSleep(unsigned long ms) override;
+};
+
+// Simulated clock for replaying recorded data. Sleeping advances simulated
+// time immediately and waits only ms / speedup of real time, so a speedup
+// of 0 runs as fast as the code allows.
+class VirtualClock : public Clock {
+public:
+    VirtualClock(time_t startTime, unsigned long speedup);
+
+    time_t now() override;
+    unsigned long millis() override;
+    void sleep(unsigned long ms) override;
+
+    void advance(unsigned long ms) { _elapsedMs += ms; }
+    uint64_t elapsedMs() const { return _elapsedMs; }
+    uint64_t sleptMs() const { return _sleptMs; }
+
+private:
+    time_t _startTime;
+    unsigned long _speedup;
+    uint64_t _elapsedMs;
+    uint64_t _sleptMs;
+};
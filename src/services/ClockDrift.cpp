@@ -0,0 +1,62 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "ClockDrift.h"
+#include <cmath>
+
+void ClockDrift::reset(ClockDriftState& state, float initialUncertaintyPpm) {
+    state.magic = 0;
+    state.syncTimeUs = 0;
+    state.ppm = 0.0f;
+    state.uncertaintyPpm = initialUncertaintyPpm;
+    state.rateSamples = 0;
+}
+
+bool ClockDrift::hasSync(const ClockDriftState& state) {
+    return state.magic == MAGIC;
+}
+
+void ClockDrift::recordSync(ClockDriftState& state, int64_t rtcTimeUs, int64_t trueTimeUs) {
+    int64_t interval = trueTimeUs - state.syncTimeUs;
+    if (hasSync(state) && interval >= MIN_RATE_INTERVAL_US) {
+        double measuredPpm = (double)(rtcTimeUs - trueTimeUs) * 1e6 / (double)interval;
+        // Both ends of the interval carry a sync error
+        double sampleStddev = M_SQRT2 * SYNC_ERROR_US * 1e6 / (double)interval;
+        double sampleVariance = sampleStddev * sampleStddev;
+        double priorVariance = (double)state.uncertaintyPpm * state.uncertaintyPpm;
+
+        // A miss bigger than the sample noise explains means the rate itself moved
+        double residual = measuredPpm - state.ppm;
+        if (residual * residual - sampleVariance > priorVariance) {
+            priorVariance = residual * residual - sampleVariance;
+        }
+
+        // Weighted by variance, so a long interval counts for more than a short
+        // one, and the first sample is blended with the assumed 0 ppm rather
+        // than taken as is
+        double gain = priorVariance / (priorVariance + sampleVariance);
+        state.ppm += (float)(gain * residual);
+        state.uncertaintyPpm = fmaxf((float)sqrt(priorVariance * (1.0 - gain)), MIN_UNCERTAINTY_PPM);
+        if (state.rateSamples < UINT16_MAX) {
+            state.rateSamples++;
+        }
+    }
+    state.magic = MAGIC;
+    state.syncTimeUs = trueTimeUs;
+}
+
+int64_t ClockDrift::correct(const ClockDriftState& state, int64_t rtcTime) {
+    if (!hasSync(state)) return rtcTime;
+    // The RTC ran (1 + ppm) seconds for every true second since the sync
+    double elapsed = (double)rtcTime - state.syncTimeUs * 1e-6;
+    return (int64_t)llround(state.syncTimeUs * 1e-6 + elapsed / (1.0 + state.ppm * 1e-6));
+}
+
+int64_t ClockDrift::predictedError(const ClockDriftState& state, int64_t rtcTime) {
+    if (!hasSync(state)) return INT64_MAX;
+    double elapsed = fabs((double)rtcTime - state.syncTimeUs * 1e-6);
+    return (int64_t)ceil(elapsed * state.uncertaintyPpm * 1e-6) + 1;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+
+// Drift estimate for the RTC that keeps time across deep sleep. Lives in RTC
+// memory, so it is a plain struct that survives a wake without construction.
+struct ClockDriftState {
+    uint32_t magic;
+    int64_t syncTimeUs;     // True time at the last NTP sync, microseconds; the RTC was set to it
+    float ppm;              // Estimated rate the RTC runs fast (+) or slow (-)
+    float uncertaintyPpm;   // How far the real rate may be from ppm
+    uint16_t rateSamples;   // Syncs that contributed to ppm
+};
+
+// Estimates RTC drift from successive NTP syncs and predicts the error of the
+// uncorrected clock in between. Syncs are measured in microseconds, so the
+// only noise on a rate sample is the sync's own error, and each sample is
+// weighted against the estimate by how long an interval it spans. No Arduino
+// dependencies, so the estimator can be exercised on the host with made-up
+// sync histories.
+class ClockDrift {
+public:
+    // Syncs closer together than this leave the rate estimate alone. Longer
+    // intervals all count, each weighted by how precisely it measures the rate.
+    static const int64_t MIN_RATE_INTERVAL_US = 600LL * 1000000;
+    // Typical error of one SNTP sync over WiFi
+    static constexpr float SYNC_ERROR_US = 20000.0f;
+
+    static void reset(ClockDriftState& state, float initialUncertaintyPpm);
+    static bool hasSync(const ClockDriftState& state);
+
+    // NTP reported trueTimeUs while the uncorrected RTC read rtcTimeUs.
+    // Updates the rate estimate and restarts the prediction from trueTimeUs.
+    static void recordSync(ClockDriftState& state, int64_t rtcTimeUs, int64_t trueTimeUs);
+
+    // Best estimate of the true time for an uncorrected RTC reading, in seconds
+    static int64_t correct(const ClockDriftState& state, int64_t rtcTime);
+    // Seconds the corrected time may still be off by
+    static int64_t predictedError(const ClockDriftState& state, int64_t rtcTime);
+
+private:
+    static const uint32_t MAGIC = 0x44524632;  // "DRF2"
+    static constexpr float MIN_UNCERTAINTY_PPM = 5.0f;
+};
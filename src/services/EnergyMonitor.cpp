@@ -0,0 +1,145 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "EnergyMonitor.h"
+#include "TimeService.h"
+#include "../storage/ConfigManager.h"
+
+namespace {
+
+const uint32_t LEDGER_MAGIC = 0x454E5247;  // "ENRG"
+const int PHASE_COUNT = (int)PowerPhase::COUNT;
+const float MS_PER_HOUR = 3600000.0f;
+
+struct EnergyLedger {
+    uint32_t magic;
+    uint32_t day;               // Local days since epoch for the "today" totals
+    uint32_t awakeMsToday;
+    float todayMah;
+    float yesterdayMah;
+    float phaseMah[PHASE_COUNT];
+    float ledMah;
+    uint32_t wakeCount;
+};
+
+RTC_DATA_ATTR EnergyLedger ledger;
+
+}
+
+PowerPhase EnergyMonitor::currentPhase = PowerPhase::BOOT;
+unsigned long EnergyMonitor::phaseStartMillis = 0;
+
+void EnergyMonitor::beginWake() {
+    if (ledger.magic != LEDGER_MAGIC) {
+        memset(&ledger, 0, sizeof(ledger));
+        ledger.magic = LEDGER_MAGIC;
+    }
+    ledger.wakeCount++;
+    currentPhase = PowerPhase::BOOT;
+    phaseStartMillis = TimeService::getMillis();
+}
+
+PowerPhase EnergyMonitor::enterPhase(PowerPhase phase) {
+    PowerPhase previous = currentPhase;
+    closeInterval();
+    currentPhase = phase;
+    return previous;
+}
+
+void EnergyMonitor::addLedFrame(uint32_t color, unsigned long durationMs) {
+    // WS2812 current scales roughly linearly with each channel's PWM duty
+    uint32_t channelSum = ((color >> 16) & 0xFF) + ((color >> 8) & 0xFF) + (color & 0xFF);
+    float dutyMa = CURRENT_LED_CHANNEL_MA * channelSum / 255.0f * ConfigManager::get().brightness / 255.0f * NUM_LEDS;
+    float mAh = dutyMa * durationMs / MS_PER_HOUR;
+    rollOverDay();
+    ledger.ledMah += mAh;
+    ledger.todayMah += mAh;
+}
+
+float EnergyMonitor::todayMah() {
+    return ledger.todayMah;
+}
+
+float EnergyMonitor::averageCurrentMa() {
+    if (ledger.awakeMsToday == 0) {
+        return 0;
+    }
+    return ledger.todayMah * MS_PER_HOUR / ledger.awakeMsToday;
+}
+
+void EnergyMonitor::printSummary() {
+    float averageMa = averageCurrentMa();
+    Serial.printf("Energy: %.2f mAh today, avg %.1f mA, est. %.1f days on %.0f mAh\n",
+        ledger.todayMah, averageMa,
+        averageMa > 0 ? BATTERY_CAPACITY_MAH / (averageMa * 24.0f) : 0.0f,
+        BATTERY_CAPACITY_MAH);
+}
+
+void EnergyMonitor::printReport() {
+    closeInterval();
+    printSummary();
+    Serial.printf("  yesterday: %.2f mAh, wakes: %lu\n", ledger.yesterdayMah, (unsigned long)ledger.wakeCount);
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        Serial.printf("  %-15s %8.3f mAh\n", phaseName((PowerPhase)i), ledger.phaseMah[i]);
+    }
+    Serial.printf("  %-15s %8.3f mAh\n", "led", ledger.ledMah);
+}
+
+void EnergyMonitor::closeInterval() {
+    unsigned long nowMillis = TimeService::getMillis();
+    unsigned long elapsed = nowMillis - phaseStartMillis;
+    phaseStartMillis = nowMillis;
+
+    float mAh = phaseCurrent(currentPhase) * elapsed / MS_PER_HOUR;
+    rollOverDay();
+    ledger.awakeMsToday += elapsed;
+    ledger.phaseMah[(int)currentPhase] += mAh;
+    ledger.todayMah += mAh;
+}
+
+void EnergyMonitor::rollOverDay() {
+    time_t localNow = TimeService::getCurrentTime() + ConfigManager::get().utcOffsetSec();
+    uint32_t day = (uint32_t)(localNow / 86400);
+    if (day != ledger.day) {
+        // Per-phase totals are kept per day as well so the report matches "today"
+        ledger.yesterdayMah = ledger.todayMah;
+        ledger.todayMah = 0;
+        ledger.awakeMsToday = 0;
+        ledger.ledMah = 0;
+        memset(ledger.phaseMah, 0, sizeof(ledger.phaseMah));
+        ledger.day = day;
+    }
+}
+
+float EnergyMonitor::phaseCurrent(PowerPhase phase) {
+    switch (phase) {
+        case PowerPhase::BOOT: return CURRENT_BOOT_MA;
+        case PowerPhase::IDLE: return CURRENT_IDLE_MA;
+        case PowerPhase::NVS_LOAD: return CURRENT_NVS_MA;
+        case PowerPhase::NVS_SAVE: return CURRENT_NVS_MA;
+        case PowerPhase::WIFI_ASSOCIATE: return CURRENT_WIFI_ASSOCIATE_MA;
+        case PowerPhase::TLS: return CURRENT_TLS_MA;
+        case PowerPhase::HTTP: return CURRENT_HTTP_MA;
+        case PowerPhase::PARSE: return CURRENT_PARSE_MA;
+        case PowerPhase::LIGHT_SLEEP: return CURRENT_LIGHT_SLEEP_MA;
+        default: return 0;
+    }
+}
+
+const char* EnergyMonitor::phaseName(PowerPhase phase) {
+    switch (phase) {
+        case PowerPhase::BOOT: return "boot";
+        case PowerPhase::IDLE: return "idle";
+        case PowerPhase::NVS_LOAD: return "nvs load";
+        case PowerPhase::NVS_SAVE: return "nvs save";
+        case PowerPhase::WIFI_ASSOCIATE: return "wifi associate";
+        case PowerPhase::TLS: return "tls";
+        case PowerPhase::HTTP: return "http";
+        case PowerPhase::PARSE: return "parse";
+        case PowerPhase::LIGHT_SLEEP: return "light sleep";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+#include "../config/config.h"
+
+// Kinds of awake interval the energy model distinguishes
+enum class PowerPhase : uint8_t {
+    BOOT,
+    IDLE,
+    NVS_LOAD,
+    NVS_SAVE,
+    WIFI_ASSOCIATE,
+    TLS,
+    HTTP,
+    PARSE,
+    LIGHT_SLEEP,
+    COUNT
+};
+
+// Estimates charge used per day from time spent in each PowerPhase and from
+// LED on-time weighted by colour and brightness. Totals live in RTC memory so
+// they survive deep sleep and soft resets. Time comes from TimeService, so the
+// replay environment can compare policies over simulated days.
+class EnergyMonitor {
+public:
+    static void beginWake();
+    static PowerPhase enterPhase(PowerPhase phase);  // Returns the phase it replaced
+    static void addLedFrame(uint32_t color, unsigned long durationMs);
+
+    static float todayMah();
+    static float averageCurrentMa();
+    static void printSummary();
+    static void printReport();
+
+private:
+    static void closeInterval();
+    static void rollOverDay();
+    static float phaseCurrent(PowerPhase phase);
+    static const char* phaseName(PowerPhase phase);
+
+    static PowerPhase currentPhase;
+    static unsigned long phaseStartMillis;
+};
+
+// Switches to a phase for the lifetime of the scope, then back
+class PowerPhaseScope {
+public:
+    explicit PowerPhaseScope(PowerPhase phase) : previous(EnergyMonitor::enterPhase(phase)) {}
+    ~PowerPhaseScope() { EnergyMonitor::enterPhase(previous); }
+
+private:
+    PowerPhase previous;
+};
@@ -0,0 +1,311 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "ProvisioningService.h"
+#include <mbedtls/ecdsa.h>
+#include <mbedtls/md.h>
+#include "TimeService.h"
+#include "EnergyMonitor.h"
+#include "../storage/TideTableStore.h"
+#include "../storage/ConfigManager.h"
+#include "../utils/FixedString.h"
+
+static_assert(sizeof(TIDE_TABLE_PUBLIC_KEY) == TIDE_TABLE_PUBLIC_KEY_SIZE,
+              "TIDE_TABLE_PUBLIC_KEY should be the 65-byte key printed by tidetable keygen, "
+              "or the template's all-zero placeholder");
+
+namespace {
+
+typedef FixedString<159> TableUrl;
+
+const int MAX_PATCHES_PER_CHECK = 8;
+const unsigned long STREAM_TIMEOUT_MS = 5000;
+
+// When tables were last checked for; RTC memory so deep sleep doesn't reset it
+RTC_DATA_ATTR time_t lastTableCheck = 0;
+
+// Checks an r||s signature over a SHA-256 digest against TIDE_TABLE_PUBLIC_KEY.
+// The device holds no key that can sign, so one read out of flash can't be
+// used to forge tables for the rest of the fleet.
+bool signatureMatches(const uint8_t* digest, const uint8_t* signature) {
+    const size_t HALF = TIDE_TABLE_SIGNATURE_SIZE / 2;
+    mbedtls_ecp_group group;
+    mbedtls_ecp_point key;
+    mbedtls_mpi r, s;
+    mbedtls_ecp_group_init(&group);
+    mbedtls_ecp_point_init(&key);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+    bool valid = mbedtls_ecp_group_load(&group, MBEDTLS_ECP_DP_SECP256R1) == 0 &&
+                 mbedtls_ecp_point_read_binary(&group, &key, TIDE_TABLE_PUBLIC_KEY, sizeof(TIDE_TABLE_PUBLIC_KEY)) == 0 &&
+                 mbedtls_mpi_read_binary(&r, signature, HALF) == 0 &&
+                 mbedtls_mpi_read_binary(&s, signature + HALF, HALF) == 0 &&
+                 mbedtls_ecdsa_verify(&group, digest, TIDE_TABLE_DIGEST_SIZE, &key, &r, &s) == 0;
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&r);
+    mbedtls_ecp_point_free(&key);
+    mbedtls_ecp_group_free(&group);
+    return valid;
+}
+
+class StreamDigest {
+public:
+    StreamDigest() {
+        mbedtls_md_init(&context);
+        mbedtls_md_setup(&context, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+        mbedtls_md_starts(&context);
+    }
+
+    ~StreamDigest() {
+        mbedtls_md_free(&context);
+    }
+
+    void update(const uint8_t* data, size_t length) {
+        mbedtls_md_update(&context, data, length);
+    }
+
+    bool matches(const uint8_t* signature) {
+        uint8_t digest[TIDE_TABLE_DIGEST_SIZE];
+        return mbedtls_md_finish(&context, digest) == 0 && signatureMatches(digest, signature);
+    }
+
+private:
+    mbedtls_md_context_t context;
+};
+
+class TableWriter : public TideTableDecoder::Listener {
+public:
+    explicit TableWriter(StreamDigest& digest) : digest(digest) {}
+
+    void onSignedBytes(const uint8_t* data, size_t length) override {
+        digest.update(data, length);
+    }
+
+    bool onHeader(const TideTableInfo& info) override {
+        if (!TideTableCodec::sameStation(info.stationId, ConfigManager::get().stationId)) {
+            return false;
+        }
+        // An older table for the same station, even correctly signed, would
+        // undo the patches applied since; a replayed download must not do that
+        TideTableInfo stored;
+        if (TideTableStore::readInfo(stored) && TideTableCodec::sameStation(stored.stationId, info.stationId) &&
+            info.revision < stored.revision) {
+            if (ENABLE_ERROR_PRINTS) {
+                Serial.printf("Tide table revision %lu is older than stored revision %lu\n",
+                    (unsigned long)info.revision, (unsigned long)stored.revision);
+            }
+            return false;
+        }
+        return TideTableStore::beginTable(info);
+    }
+
+    bool onRecord(const TideTableRecord& record) override {
+        return TideTableStore::appendRecord(record);
+    }
+
+private:
+    StreamDigest& digest;
+};
+
+}
+
+uint8_t ProvisioningService::patchBuffer[];
+
+bool ProvisioningService::isCheckDue(time_t now) {
+    return lastTableCheck == 0 || now - lastTableCheck >= TABLE_CHECK_INTERVAL;
+}
+
+bool ProvisioningService::hasPublicKey() {
+    return TIDE_TABLE_PUBLIC_KEY[0] == 0x04;  // Uncompressed point; the placeholder is all zero
+}
+
+bool ProvisioningService::updateTables(time_t now) {
+#ifdef REPLAY_MODE
+    return false;
+#else
+    lastTableCheck = now;
+    if (!hasPublicKey()) {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.println("No TIDE_TABLE_PUBLIC_KEY set; tide tables disabled");
+        }
+        return false;
+    }
+
+    TideTableInfo info;
+    if (!TideTableStore::readInfo(info) ||
+        !TideTableCodec::sameStation(info.stationId, ConfigManager::get().stationId) ||
+        TideTableStore::coverageEnd() < now + TABLE_RENEW_MARGIN) {
+        return downloadTable();
+    }
+
+    bool patched = false;
+    for (int i = 0; i < MAX_PATCHES_PER_CHECK && downloadPatch(info.revision); i++) {
+        patched = true;
+        TideTableStore::readInfo(info);
+    }
+    return patched;
+#endif
+}
+
+bool ProvisioningService::beginRequest(HTTPClient& http, WiFiClientSecure& client, const char* url) {
+    client.setInsecure(); // Tables and patches are signed with a key no device holds, so transport trust isn't needed
+    client.setTimeout(5);
+    http.setTimeout(5000);
+    http.useHTTP10(true); // No chunked encoding, so the body can be read straight off the stream
+    if (!http.begin(client, url)) {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.printf("HTTP begin failed for %s\n", url);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ProvisioningService::downloadTable() {
+    TableUrl url;
+    url.append(TIDE_TABLE_URL).append(ConfigManager::get().stationId).append(".tbl");
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("Downloading tide table %s\n", url.c_str());
+    }
+
+    WiFiClientSecure client;
+    HTTPClient http;
+    if (!beginRequest(http, client, url.c_str())) {
+        return false;
+    }
+
+    PowerPhaseScope phase(PowerPhase::TLS);
+    int httpCode = http.GET();
+    if (httpCode != HTTP_CODE_OK) {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.printf("Tide table request failed: %d\n", httpCode);
+        }
+        http.end();
+        return false;
+    }
+    EnergyMonitor::enterPhase(PowerPhase::HTTP);
+
+    // Decode as the bytes arrive; only one small buffer is ever held in RAM
+    StreamDigest digest;
+    TableWriter writer(digest);
+    TideTableDecoder decoder(writer);
+    WiFiClient* stream = http.getStreamPtr();
+    uint8_t buffer[256];
+    size_t received = 0;
+    unsigned long startMillis = millis();
+    unsigned long lastDataMillis = startMillis;
+    bool failed = false;
+
+    while (!decoder.finished() && !failed && millis() - lastDataMillis < STREAM_TIMEOUT_MS) {
+        int available = stream->available();
+        if (available <= 0) {
+            if (!http.connected()) {
+                break;
+            }
+            delay(1);
+            continue;
+        }
+        int length = stream->read(buffer, min((size_t)available, sizeof(buffer)));
+        if (length <= 0) {
+            continue;
+        }
+        lastDataMillis = millis();
+        received += length;
+        failed = !decoder.feed(buffer, length);
+    }
+    http.end();
+
+    if (!decoder.finished() || !digest.matches(decoder.signature())) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Tide table download incomplete or signature mismatch");
+        }
+        TideTableStore::abortTable();
+        return false;
+    }
+    if (!TideTableStore::commitTable()) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Failed to store tide table");
+        }
+        return false;
+    }
+
+    if (ENABLE_DEBUG_PRINTS) {
+        unsigned long elapsed = max(millis() - startMillis, 1UL);
+        Serial.printf("Stored %lu extremes from %u bytes in %lu ms (%lu bytes/s)\n",
+            (unsigned long)decoder.recordsDecoded(), (unsigned int)received, elapsed,
+            (unsigned long)(received * 1000UL / elapsed));
+    }
+    return true;
+}
+
+bool ProvisioningService::downloadPatch(uint32_t revision) {
+    TableUrl url;
+    url.append(TIDE_TABLE_URL).append(ConfigManager::get().stationId).appendf(".%lu.patch", (unsigned long)revision);
+
+    WiFiClientSecure client;
+    HTTPClient http;
+    if (!beginRequest(http, client, url.c_str())) {
+        return false;
+    }
+
+    PowerPhaseScope phase(PowerPhase::TLS);
+    int httpCode = http.GET();
+    int size = http.getSize();
+    if (httpCode != HTTP_CODE_OK || size <= 0 || (size_t)size > sizeof(patchBuffer)) {
+        // 404 just means there is nothing newer than this revision
+        http.end();
+        return false;
+    }
+    EnergyMonitor::enterPhase(PowerPhase::HTTP);
+
+    WiFiClient* stream = http.getStreamPtr();
+    size_t received = 0;
+    unsigned long lastDataMillis = millis();
+    while (received < (size_t)size && millis() - lastDataMillis < STREAM_TIMEOUT_MS) {
+        int length = stream->read(patchBuffer + received, size - received);
+        if (length > 0) {
+            received += length;
+            lastDataMillis = millis();
+        } else {
+            delay(1);
+        }
+    }
+    http.end();
+
+    return received == (size_t)size && applySignedPatch(patchBuffer, received);
+}
+
+bool ProvisioningService::applySignedPatch(const uint8_t* data, size_t length) {
+    TideTablePatchInfo patch;
+    if (!TideTableCodec::parsePatch(data, length, patch) || !signatureValid(data, length)) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Invalid tide table patch");
+        }
+        return false;
+    }
+    if (!TideTableStore::applyPatch(patch, data)) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Tide table patch rejected");
+        }
+        return false;
+    }
+
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("Applied tide table patch %lu -> %lu (%u entries)\n",
+            (unsigned long)patch.fromRevision, (unsigned long)patch.toRevision, patch.count);
+    }
+    return true;
+}
+
+bool ProvisioningService::signatureValid(const uint8_t* data, size_t length) {
+    if (length < TIDE_TABLE_SIGNATURE_SIZE || !hasPublicKey()) {
+        return false;
+    }
+    size_t signedLength = length - TIDE_TABLE_SIGNATURE_SIZE;
+    uint8_t digest[TIDE_TABLE_DIGEST_SIZE];
+    return mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), data, signedLength, digest) == 0 &&
+           signatureMatches(digest, data + signedLength);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include "../models/TideTable.h"
+#include "../config/config.h"
+#include "../config/wifi_credentials.h"
+
+// Downloads a year of extremes for the configured station as one signed tide table,
+// streaming it into flash through TideTableStore, and later applies signed
+// patches to it. Between checks the table serves every refresh without WiFi.
+class ProvisioningService {
+public:
+    static bool isCheckDue(time_t now);
+    // False while TIDE_TABLE_PUBLIC_KEY is the template's all-zero placeholder
+    static bool hasPublicKey();
+    static bool updateTables(time_t now);  // WiFi must be connected
+
+    // A whole signed patch held in memory, downloaded or pushed
+    static bool applySignedPatch(const uint8_t* data, size_t length);
+    // Whether the last TIDE_TABLE_SIGNATURE_SIZE bytes sign everything before them
+    static bool signatureValid(const uint8_t* data, size_t length);
+
+private:
+    static bool downloadTable();
+    static bool downloadPatch(uint32_t revision);
+    static bool beginRequest(HTTPClient& http, WiFiClientSecure& client, const char* url);
+
+    static uint8_t patchBuffer[TIDE_TABLE_PATCH_HEADER_SIZE +
+                               TIDE_TABLE_MAX_PATCH_ENTRIES * TIDE_TABLE_PATCH_ENTRY_SIZE +
+                               TIDE_TABLE_SIGNATURE_SIZE];
+};
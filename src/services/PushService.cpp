@@ -0,0 +1,209 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "PushService.h"
+#include "TimeService.h"
+#include "ProvisioningService.h"
+#include "../storage/TideTableStore.h"
+#include "../storage/ConfigManager.h"
+#include "../display/LedController.h"
+
+namespace {
+
+const uint32_t LEVEL_RECORD_MAGIC = 0x4C56534E;  // "LVSN"
+
+// The sequence of the last level reading taken. Kept across resets, so a
+// reading captured before one can't be replayed after it.
+struct LevelRecord {
+    uint32_t magic;
+    uint32_t sequence;
+};
+
+RTC_DATA_ATTR LevelRecord levelRecord;
+
+}
+
+WiFiClient PushService::wifiClient;
+PubSubClient PushService::client(PushService::wifiClient);
+TideData* PushService::target = nullptr;
+TopicString PushService::patchTopic;
+TopicString PushService::levelTopic;
+unsigned long PushService::nextAttemptMillis = 0;
+unsigned long PushService::backoffMs = PUSH_MIN_BACKOFF_MS;
+bool PushService::catchUpNeeded = false;
+unsigned long PushService::lastCatchUpMillis = 0;
+bool PushService::caughtUp = false;
+PushService::QueuedPatch PushService::patchQueue[PUSH_PATCH_QUEUE_DEPTH];
+uint8_t PushService::patchQueueStart = 0;
+uint8_t PushService::patchQueueCount = 0;
+
+void PushService::begin(TideData& tideData) {
+    target = &tideData;
+    const char* station = ConfigManager::get().stationId;
+    patchTopic.clear();
+    patchTopic.append(PUSH_TOPIC_PREFIX).append(station).append("/patch");
+    levelTopic.clear();
+    levelTopic.append(PUSH_TOPIC_PREFIX).append(station).append("/level");
+
+    client.setServer(MQTT_BROKER_HOST, MQTT_BROKER_PORT);
+    client.setCallback(onMessage);
+    client.setKeepAlive(PUSH_KEEPALIVE_SEC);
+    wifiClient.setTimeout(PUSH_CONNECT_TIMEOUT_SEC);     // Bounds the TCP connect
+    client.setSocketTimeout(PUSH_CONNECT_TIMEOUT_SEC);  // And the wait for the broker's reply
+    if (!client.setBufferSize(BUFFER_SIZE)) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Push: no memory for the MQTT buffer");
+        }
+        target = nullptr;
+    }
+}
+
+void PushService::loop() {
+    if (target == nullptr) return;
+
+    bool connected = client.connected();
+    if (connected) {
+        client.loop();  // Takes whatever has arrived and returns
+    }
+    applyQueuedPatches();
+    if (connected) return;
+
+    unsigned long now = TimeService::getMillis();
+    if ((long)(now - nextAttemptMillis) < 0) return;
+    if (connect()) {
+        backoffMs = PUSH_MIN_BACKOFF_MS;
+        return;
+    }
+    // Jitter so a fleet doesn't reconnect in lockstep after a broker restart
+    nextAttemptMillis = now + backoffMs + random(0, backoffMs / 4 + 1);
+    backoffMs = min(backoffMs * 2, PUSH_MAX_BACKOFF_MS);
+}
+
+bool PushService::connect() {
+    // The WiFi driver reconnects by itself; don't block here waiting for it
+    if (WiFi.status() != WL_CONNECTED) {
+        return false;
+    }
+
+    char clientId[32];
+    snprintf(clientId, sizeof(clientId), "tide-%s-%08lx",
+        ConfigManager::get().stationId, (unsigned long)ESP.getEfuseMac());
+    bool anonymous = MQTT_USERNAME[0] == '\0';
+    // A persistent session, so the broker holds patches published while we were away
+    if (!client.connect(clientId, anonymous ? nullptr : MQTT_USERNAME, anonymous ? nullptr : MQTT_PASSWORD,
+                        nullptr, 0, false, nullptr, false)) {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.printf("Push: MQTT connect failed (state %d), retrying in %lu ms\n", client.state(), backoffMs);
+        }
+        return false;
+    }
+    client.subscribe(patchTopic.c_str(), 1);
+    client.subscribe(levelTopic.c_str(), 1);
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("Push: subscribed to %s and %s\n", patchTopic.c_str(), levelTopic.c_str());
+    }
+    // Anything published before the session existed is only on the table server
+    catchUpNeeded = true;
+    return true;
+}
+
+void PushService::onMessage(char* topic, uint8_t* payload, unsigned int length) {
+    unsigned long receivedMillis = TimeService::getMillis();
+    if (strcmp(topic, patchTopic.c_str()) == 0) {
+        handlePatch(payload, length, receivedMillis);
+    } else if (strcmp(topic, levelTopic.c_str()) == 0) {
+        handleLevel(payload, length);
+    }
+}
+
+void PushService::handlePatch(const uint8_t* payload, unsigned int length, unsigned long receivedMillis) {
+    if (length > MAX_PATCH_SIZE || patchQueueCount == PUSH_PATCH_QUEUE_DEPTH) {
+        // Whatever can't be held is left to the HTTP catch-up
+        catchUpNeeded = true;
+        return;
+    }
+    QueuedPatch& queued = patchQueue[(patchQueueStart + patchQueueCount) % PUSH_PATCH_QUEUE_DEPTH];
+    memcpy(queued.data, payload, length);
+    queued.length = length;
+    queued.receivedMillis = receivedMillis;
+    patchQueueCount++;
+}
+
+void PushService::applyQueuedPatches() {
+    while (patchQueueCount > 0) {
+        const QueuedPatch& queued = patchQueue[patchQueueStart];
+        patchQueueStart = (patchQueueStart + 1) % PUSH_PATCH_QUEUE_DEPTH;
+        patchQueueCount--;
+
+        // A retained patch comes again with every subscribe; one the table
+        // already has is dropped without setting off a catch-up
+        TideTablePatchInfo patch;
+        TideTableInfo stored;
+        if (TideTableCodec::parsePatch(queued.data, queued.length, patch) && TideTableStore::readInfo(stored) &&
+            TideTableCodec::sameStation(patch.stationId, stored.stationId) && patch.toRevision <= stored.revision) {
+            continue;
+        }
+        if (!ProvisioningService::applySignedPatch(queued.data, queued.length)) {
+            // Usually a patch for a later revision than ours
+            catchUpNeeded = true;
+            continue;
+        }
+        TideTableStore::loadWindow(*target, TimeService::getCurrentTime());
+        LedController::requestRefresh(queued.receivedMillis);
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.printf("Push: patch of %u bytes applied %lu ms after it arrived\n",
+                queued.length, TimeService::getMillis() - queued.receivedMillis);
+        }
+    }
+}
+
+bool PushService::takeCatchUp(unsigned long nowMillis) {
+    if (!catchUpNeeded || (caughtUp && nowMillis - lastCatchUpMillis < PUSH_CATCHUP_INTERVAL_MS)) {
+        return false;
+    }
+    catchUpNeeded = false;
+    lastCatchUpMillis = nowMillis;
+    caughtUp = true;
+    return true;
+}
+
+void PushService::handleLevel(const uint8_t* payload, unsigned int length) {
+    TideLevelReading reading;
+    if (!TideTableCodec::parseLevel(payload, length, reading)) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Push: invalid level reading");
+        }
+        return;
+    }
+    // A signature alone doesn't stop a reading for another station, or one
+    // captured earlier, from being replayed. These checks are also much cheaper
+    // than verifying the signature, so they go first.
+    time_t now = TimeService::getCurrentTime();
+    bool hasSequence = levelRecord.magic == LEVEL_RECORD_MAGIC;
+    if (!TideTableCodec::sameStation(reading.stationId, ConfigManager::get().stationId) ||
+        (hasSequence && reading.sequence <= levelRecord.sequence) ||
+        reading.timestamp < (int64_t)now - PUSH_LEVEL_MAX_AGE_SEC ||
+        reading.timestamp > (int64_t)now + PUSH_LEVEL_MAX_AHEAD_SEC) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Push: stale or misdirected level reading");
+        }
+        return;
+    }
+    if (!ProvisioningService::signatureValid(payload, length)) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Push: invalid level reading");
+        }
+        return;
+    }
+    levelRecord.magic = LEVEL_RECORD_MAGIC;
+    levelRecord.sequence = reading.sequence;
+
+    bool blended = target->observeLevel((time_t)reading.timestamp, reading.heightCm / 100.0f);
+    LedController::requestRefresh(TimeService::getMillis());
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("Push: observed level %.2f m%s\n", target->currentHeight, blended ? "" : " (not blended)");
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include "../models/TideData.h"
+#include "../models/TideTable.h"
+#include "../config/config.h"
+#include "../config/wifi_credentials.h"
+#include "../utils/FixedString.h"
+
+typedef FixedString<47> TopicString;
+
+// Push mode for mains-powered installs. Keeps an MQTT session open and
+// applies the station's signed table patches and level readings as they are
+// published, instead of waiting for needsUpdate.
+//
+// loop() handles what has arrived and returns. Patches are only copied in
+// the MQTT callback and written to the table after it, so PubSubClient isn't
+// held up by LittleFS. Connecting is the exception: PubSubClient connects
+// synchronously, so an attempt can hold the loop for the DNS lookup plus up
+// to PUSH_CONNECT_TIMEOUT_SEC each for the TCP connect and the broker's reply. Failed attempts back off exponentially. A missed
+// patch is not fetched here; takeCatchUp() tells the main loop when to do it.
+class PushService {
+public:
+    static void begin(TideData& tideData);  // WiFi should already be connected
+    static void loop();
+    static bool isConnected() { return client.connected(); }
+
+    // True at most once per PUSH_CATCHUP_INTERVAL_MS while patches may have
+    // been missed. The caller then updates the table over HTTP, outside the
+    // MQTT callback, and calls requestCatchUp() again if that fails.
+    static bool takeCatchUp(unsigned long nowMillis);
+    static void requestCatchUp() { catchUpNeeded = true; }
+
+private:
+    static bool connect();
+    static void onMessage(char* topic, uint8_t* payload, unsigned int length);
+    static void handlePatch(const uint8_t* payload, unsigned int length, unsigned long receivedMillis);
+    static void handleLevel(const uint8_t* payload, unsigned int length);
+    static void applyQueuedPatches();
+
+    static const uint16_t MAX_PATCH_SIZE = TIDE_TABLE_PATCH_HEADER_SIZE +
+                                           TIDE_TABLE_MAX_PATCH_ENTRIES * TIDE_TABLE_PATCH_ENTRY_SIZE +
+                                           TIDE_TABLE_SIGNATURE_SIZE;
+    // Room for the largest signed patch plus MQTT framing, so PubSubClient
+    // allocates its buffer once
+    static const uint16_t BUFFER_SIZE = MAX_PATCH_SIZE + 128;
+
+    // A patch copied out of PubSubClient's buffer, which the next message overwrites
+    struct QueuedPatch {
+        unsigned long receivedMillis;
+        uint16_t length;
+        uint8_t data[MAX_PATCH_SIZE];
+    };
+
+    static WiFiClient wifiClient;
+    static PubSubClient client;
+    static TideData* target;
+    static TopicString patchTopic;
+    static TopicString levelTopic;
+    static unsigned long nextAttemptMillis;
+    static unsigned long backoffMs;
+    static bool catchUpNeeded;  // A patch was missed; fetch the gap over HTTP
+    static unsigned long lastCatchUpMillis;
+    static bool caughtUp;       // lastCatchUpMillis is set
+    static QueuedPatch patchQueue[PUSH_PATCH_QUEUE_DEPTH];
+    static uint8_t patchQueueStart;
+    static uint8_t patchQueueCount;
+};
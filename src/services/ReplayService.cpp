@@ -0,0 +1,115 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#ifdef REPLAY_MODE
+
+#include "ReplayService.h"
+#include "TimeService.h"
+#include "TideService.h"
+#include "EnergyMonitor.h"
+
+#ifndef REPLAY_SPEEDUP
+#define REPLAY_SPEEDUP 0  // As fast as possible
+#endif
+
+// Recorded by scripts/record_tide_responses.py: one "<fetch epoch> <json>" per
+// line, in time order, closed by an "<epoch> END" line
+extern const char replayResponsesStart[] asm("_binary_replay_tide_responses_txt_start");
+extern const char replayResponsesEnd[] asm("_binary_replay_tide_responses_txt_end");
+
+VirtualClock* ReplayService::clock = nullptr;
+unsigned long ReplayService::realStartMillis = 0;
+unsigned long ReplayService::fetchCount = 0;
+unsigned long ReplayService::nvsWriteCount = 0;
+unsigned long ReplayService::ledChangeCount = 0;
+
+void ReplayService::begin() {
+    time_t startTime = (time_t)strtoll(replayResponsesStart, nullptr, 10);
+    static VirtualClock virtualClock(startTime, REPLAY_SPEEDUP);
+    clock = &virtualClock;
+    TimeService::setClock(clock);
+    realStartMillis = millis();
+
+    Serial.println("time,event,detail");
+    logEvent("START", "speedup=%lu", (unsigned long)REPLAY_SPEEDUP);
+}
+
+bool ReplayService::fetchTideData(TideData& tideData) {
+    time_t now = TimeService::getCurrentTime();
+    const char* end = nullptr;
+    const char* response = findResponse(now, &end);
+    if (response == nullptr) {
+        finish();
+    }
+
+    // JSON.parse needs a terminated string, so copy the line out of flash
+    String payload;
+    payload.concat(response, end - response);
+    bool success = TideService::parseTideResponse(payload.c_str(), tideData, now);
+    fetchCount++;
+    logEvent("FETCH", "%s", success ? "ok" : "failed");
+    return success;
+}
+
+const char* ReplayService::findResponse(time_t now, const char** end) {
+    // Use the latest recording made at or before now
+    const char* found = nullptr;
+    const char* line = replayResponsesStart;
+    while (line < replayResponsesEnd && *line != '\0') {
+        char* json = nullptr;
+        time_t fetchTime = (time_t)strtoll(line, &json, 10);
+        if (fetchTime > now) {
+            break;
+        }
+        while (*json == ' ') {
+            json++;
+        }
+        const char* lineEnd = (const char*)memchr(json, '\n', replayResponsesEnd - json);
+        if (lineEnd == nullptr) {
+            lineEnd = replayResponsesEnd;
+        }
+        found = json;
+        *end = lineEnd;
+        line = lineEnd + 1;
+    }
+
+    // The recording ends with an "<epoch> END" line
+    if (found != nullptr && strncmp(found, "END", 3) == 0) {
+        return nullptr;
+    }
+    return found;
+}
+
+void ReplayService::logEvent(const char* event, const char* format, ...) {
+    if (strcmp(event, "NVS_WRITE") == 0) {
+        nvsWriteCount++;
+    } else if (strcmp(event, "LED") == 0) {
+        ledChangeCount++;
+    }
+
+    char detail[64];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(detail, sizeof(detail), format, args);
+    va_end(args);
+    Serial.printf("%lld,%s,%s\n", (long long)TimeService::getCurrentTime(), event, detail);
+}
+
+void ReplayService::finish() {
+    unsigned long realMs = millis() - realStartMillis;
+    uint64_t simulatedMs = clock->elapsedMs();
+    logEvent("END", "recording exhausted");
+    Serial.printf("# simulated %.2f days in %.1f s (%.0fx)\n",
+        simulatedMs / 86400000.0, realMs / 1000.0, realMs > 0 ? (double)simulatedMs / realMs : 0.0);
+    Serial.printf("# fetches %lu, NVS writes %lu, LED changes %lu, asleep %.1f%%\n",
+        fetchCount, nvsWriteCount, ledChangeCount, simulatedMs > 0 ? clock->sleptMs() * 100.0 / simulatedMs : 0.0);
+    EnergyMonitor::printReport();
+    while (true) {
+        delay(1000);
+    }
+}
+
+#endif // REPLAY_MODE
@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+#include "../models/TideData.h"
+#include "../config/config.h"
+#include "Clock.h"
+
+// Replay mode runs the normal setup()/loop() against recorded tide responses
+// on a VirtualClock and prints a CSV timeline of what the device did:
+//   <simulated epoch>,<event>,<detail>
+// Build with the replay environment: pio run -e replay -t upload
+class ReplayService {
+public:
+#ifdef REPLAY_MODE
+    static void begin();
+    static bool fetchTideData(TideData& tideData);
+    static void logEvent(const char* event, const char* format, ...) __attribute__((format(printf, 2, 3)));
+#else
+    static void begin() {}
+    static void logEvent(const char*, const char*, ...) {}
+#endif
+
+private:
+#ifdef REPLAY_MODE
+    static const char* findResponse(time_t now, const char** end);
+    static void finish();
+
+    static VirtualClock* clock;
+    static unsigned long realStartMillis;
+    static unsigned long fetchCount;
+    static unsigned long nvsWriteCount;
+    static unsigned long ledChangeCount;
+#endif
+};
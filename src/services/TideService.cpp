@@ -6,8 +6,15 @@
 
 #include "TideService.h"
 #include "WiFiService.h"
+#include "ReplayService.h"
+#include "EnergyMonitor.h"
+#include "../storage/ConfigManager.h"
+#include "../utils/TideResponseParser.h"
 
 bool TideService::fetchTideData(TideData& tideData) {
+#ifdef REPLAY_MODE
+    return ReplayService::fetchTideData(tideData);
+#else
     if (!WiFiService::isConnected()) {
         if (ENABLE_DEBUG_PRINTS) {
             Serial.println("WiFi not connected");
@@ -37,7 +44,8 @@ bool TideService::fetchTideData(TideData& tideData) {
     time_t startTime = now - (24 * 60 * 60); // 12 hours ago (reduced from 24)
     time_t endTime = now + (24 * 5 * 60 * 60);   // 12 hours ahead
     
-    String query = buildGraphQLQuery(startTime, endTime);
+    QueryString query;
+    buildGraphQLQuery(startTime, endTime, query);
     if (ENABLE_DEBUG_PRINTS) {
         Serial.printf("GraphQL query: %s\n", query.c_str());
     }
@@ -54,7 +62,10 @@ bool TideService::fetchTideData(TideData& tideData) {
     if (ENABLE_DEBUG_PRINTS) {
         Serial.println("Starting HTTP POST...");
     }
-    int httpCode = http.POST(query);
+    // HTTPClient connects inside POST, so this phase covers the TLS handshake and the request
+    PowerPhaseScope phase(PowerPhase::TLS);
+    int httpCode = http.POST((uint8_t*)query.data(), query.length());
+    EnergyMonitor::enterPhase(PowerPhase::HTTP);
 
     if (httpCode != HTTP_CODE_OK) {
         if (ENABLE_DEBUG_PRINTS) {
@@ -77,149 +88,35 @@ bool TideService::fetchTideData(TideData& tideData) {
         return false;
     }
 
-    if (ENABLE_DEBUG_PRINTS) {
-        Serial.printf("Response length: %d\n", payload.length());
-        Serial.printf("Response: %s\n", payload.c_str());
-        Serial.println("Parsing JSON...");
-    }
-    JSONVar doc = JSON.parse(payload);
-    if (JSON.typeof(doc) == "undefined") {
-        if (ENABLE_DEBUG_PRINTS) {
-            Serial.println("JSON parsing failed");
-        }
-        return false;
-    }
-
-    // Navigate through GraphQL response structure
-    if (!doc.hasOwnProperty("data") || !doc["data"].hasOwnProperty("tides")) {
-        if (ENABLE_DEBUG_PRINTS) {
-            Serial.println("Invalid GraphQL response structure");
-        }
-        return false;
-    }
-
-    JSONVar tides = doc["data"]["tides"];
-
-    // Update current tide data
-    if (ENABLE_DEBUG_PRINTS) {
-        Serial.println("Updating tide data...");
-    }
-    String typeStr = JSON.stringify(tides["tideType"]);
-    if (typeStr.length() > 2) {
-        tideData.type = typeStr.substring(1, typeStr.length() - 1); // Remove quotes
-    } else {
-        tideData.type = "UNKNOWN";
-    }
-    
-    tideData.currentHeight = (double)tides["waterLevel"];
-    tideData.lastUpdateTime = now;
-
-    // Process tide extremes
-    if (ENABLE_DEBUG_PRINTS) {
-        Serial.println("Processing extremes...");
-    }
-    if (tides.hasOwnProperty("extremes")) {
-        JSONVar extremes = tides["extremes"];
-        processTideExtremes(extremes, tideData, now);
-    } else {
-        if (ENABLE_DEBUG_PRINTS) {
-            Serial.println("No extremes data in response");
-        }
-        return false;
-    }
+    return parseTideResponse(payload.c_str(), tideData, now);
+#endif
+}
 
+bool TideService::parseTideResponse(const char* payload, TideData& tideData, time_t now) {
+    PowerPhaseScope phase(PowerPhase::PARSE);
     if (ENABLE_DEBUG_PRINTS) {
-        Serial.println("Tide data fetch completed successfully");
+        Serial.printf("Response length: %d\n", (int)strlen(payload));
+        Serial.printf("Response: %s\n", payload);
     }
-    return true;
+    return TideResponseParser::parse(payload, tideData, now);
 }
 
-String TideService::buildGraphQLQuery(time_t startTime, time_t endTime) {
-    char startBuff[25], endBuff[25];
-    struct tm timeinfo;
-    
-    localtime_r(&startTime, &timeinfo);
-    strftime(startBuff, sizeof(startBuff), "%Y-%m-%dT%H:%M:%S", &timeinfo);
-    
-    localtime_r(&endTime, &timeinfo);
-    strftime(endBuff, sizeof(endBuff), "%Y-%m-%dT%H:%M:%S", &timeinfo);
-
-    String query = "{"
-                  "\"operationName\": \"GetTides\","
-                  "\"variables\": {"
-                  "\"stationId\": \"" + String(TIDE_STATION_ID) + "\","
-                  "\"startDateTime\": \"" + String(startBuff) + "\","
-                  "\"endDateTime\": \"" + String(endBuff) + "\""
-                  "},"
-                  "\"query\": \"query GetTides($stationId: ID!, $startDateTime: String!, $endDateTime: String!) {\\n"
-                  "  tides(\\n"
-                  "    stationId: $stationId\\n"
-                  "    startDateTime: $startDateTime\\n"
-                  "    endDateTime: $endDateTime\\n"
-                  "  ) {\\n"
-                  "    localTime\\n"
-                  "    waterLevel\\n"
-                  "    tideType\\n"
-                  "    timeZoneOffsetSeconds\\n"
-                  "    extremes {\\n"
-                  "      type\\n"
-                  "      timestamp\\n"
-                  "      height\\n"
-                  "    }\\n"
-                  "  }\\n"
-                  "}\""
-                  "}";
-    return query;
+void TideService::buildGraphQLQuery(time_t startTime, time_t endTime, QueryString& query) {
+    // The request body is generated around the station id; only the two datetimes change
+    query.clear();
+    query.append(QUERY_HEAD).append(ConfigManager::get().stationId);
+    size_t tail = query.length();
+    query.append(QUERY_TAIL);
+    patchDateTime(query.data() + tail + QUERY_START_OFFSET, startTime);
+    patchDateTime(query.data() + tail + QUERY_END_OFFSET, endTime);
 }
 
-void TideService::processTideExtremes(JSONVar& extremes, TideData& tideData, time_t now) {
-    // Find most recent past extreme
-    int mostRecentPastIndex = -1;
-    time_t now_utc = now + GMT_OFFSET_SEC + DAYLIGHT_OFFSET_SEC;
-    
-    if (ENABLE_DEBUG_PRINTS) {
-        Serial.printf("Processing %d extremes...\n", (int)extremes.length());
-    }
-    
-    for (int i = 0; i < extremes.length(); i++) {
-        double rawTimestamp = (double)extremes[i]["timestamp"];
-        time_t timestamp = (time_t)(rawTimestamp / 1000) - GMT_OFFSET_SEC - DAYLIGHT_OFFSET_SEC;
-        if (timestamp <= now) {
-            if (mostRecentPastIndex == -1 || 
-                timestamp > (time_t)((double)extremes[mostRecentPastIndex]["timestamp"] / 1000) - GMT_OFFSET_SEC - DAYLIGHT_OFFSET_SEC) {
-                mostRecentPastIndex = i;
-            }
-        }
-    }
-
-    // Store most recent past extreme
-    if (mostRecentPastIndex != -1) {
-        if (ENABLE_DEBUG_PRINTS) {
-            Serial.println("Found recent past extreme");
-        }
-        time_t timestamp = (time_t)((double)extremes[mostRecentPastIndex]["timestamp"] / 1000);
-        tideData.current.timestamp = timestamp;
-        tideData.current.height = (double)extremes[mostRecentPastIndex]["height"];
-        String typeStr = JSON.stringify(extremes[mostRecentPastIndex]["type"]);
-        tideData.current.isHigh = typeStr.indexOf("HIGH") != -1;
-    }
+void TideService::patchDateTime(char* dest, time_t timestamp) {
+    char buff[QUERY_DATETIME_LENGTH + 1];
+    struct tm timeinfo;
 
-    // Store future extremes
-    if (ENABLE_DEBUG_PRINTS) {
-        Serial.println("Processing future extremes...");
-    }
-    tideData.numExtremes = 0;
-    for (int i = 0; i < extremes.length() && tideData.numExtremes < MAX_EXTREMES; i++) {
-        time_t timestamp = (time_t)((double)extremes[i]["timestamp"] / 1000);
-        if (timestamp > now) {
-            tideData.extremes[tideData.numExtremes].timestamp = timestamp;
-            tideData.extremes[tideData.numExtremes].height = (double)extremes[i]["height"];
-            String typeStr = JSON.stringify(extremes[i]["type"]);
-            tideData.extremes[tideData.numExtremes].isHigh = typeStr.indexOf("HIGH") != -1;
-            tideData.numExtremes++;
-        }
-    }
-    if (ENABLE_DEBUG_PRINTS) {
-        Serial.printf("Stored %d future extremes\n", tideData.numExtremes);
+    localtime_r(&timestamp, &timeinfo);
+    if (strftime(buff, sizeof(buff), "%Y-%m-%dT%H:%M:%S", &timeinfo) == QUERY_DATETIME_LENGTH) {
+        memcpy(dest, buff, QUERY_DATETIME_LENGTH);
     }
 }
@@ -2,20 +2,25 @@
 #include <Arduino.h>
 #include <WiFiClientSecure.h>
 #include <HTTPClient.h>
-#include <Arduino_JSON.h>
 #include "esp32-hal.h"  // For ESP32 specific functions
 #include "../models/TideData.h"
+#include "../utils/JsonHelper.h"
 #include "../config/config.h"
 #include "../config/wifi_credentials.h"
 #include "TimeService.h"
 #include "WiFiService.h"
+#include "../utils/FixedString.h"
+
+// Exactly fits the longest station id
+typedef FixedString<sizeof(QUERY_HEAD) - 1 + STATION_ID_CAPACITY + sizeof(QUERY_TAIL) - 1> QueryString;
 
 class TideService {
 public:
     static bool fetchTideData(TideData& tideData);
+    static bool parseTideResponse(const char* payload, TideData& tideData, time_t now);
     
 private:
-    static String buildGraphQLQuery(time_t startTime, time_t endTime);
-    static void processTideExtremes(JSONVar& extremes, TideData& tideData, time_t now);
+    static void buildGraphQLQuery(time_t startTime, time_t endTime, QueryString& query);
+    static void patchDateTime(char* dest, time_t timestamp);
     static void feedWatchdog();
 };
@@ -5,17 +5,116 @@
  */
 
 #include "TimeService.h"
+#include "ReplayService.h"
+#include "EnergyMonitor.h"
+#include "ClockDrift.h"
+#include "../storage/ConfigManager.h"
+#include <esp_sntp.h>
+#include <climits>
+#include <sys/time.h>
 
-void TimeService::initialize() {
-    configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
+SystemClock TimeService::systemClock;
+Clock* TimeService::clock = &TimeService::systemClock;
+unsigned long TimeService::lastSyncAttempt = 0;
+bool TimeService::syncAttempted = false;
+
+// Survives deep sleep along with the RTC it describes
+RTC_DATA_ATTR ClockDriftState driftState;
+
+#ifndef REPLAY_MODE
+// The RTC to the microsecond; time() would round drift measurements to whole seconds
+static int64_t wallMicros() {
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+}
+#endif
+
+bool TimeService::initialize() {
+    bool synced = true;
+#ifndef REPLAY_MODE
+    markSyncAttempt();
+    int64_t rtcBeforeUs = wallMicros();
+    unsigned long startMicros = micros();
+
+    sntp_set_sync_status(SNTP_SYNC_STATUS_RESET);
+    configTime(ConfigManager::get().gmtOffsetSec, ConfigManager::get().daylightOffsetSec, NTP_SERVER);
+    synced = waitForSync(NTP_SYNC_TIMEOUT_MS);
+    // Left running, SNTP would reset the clock in the background whenever
+    // WiFi stays up (push mode) without the drift estimate knowing
+    sntp_stop();
+
+    if (synced) {
+        // micros() runs from the main crystal, so it bridges the wait without RTC drift
+        unsigned long bridgeUs = micros() - startMicros;
+        int64_t trueUs = wallMicros();
+        int64_t rtcUs = rtcBeforeUs + (int64_t)bridgeUs;
+        if (!ClockDrift::hasSync(driftState) || rtcBeforeUs < (int64_t)MIN_VALID_TIME * 1000000) {
+            ClockDrift::reset(driftState, RTC_DRIFT_UNCERTAINTY_PPM);
+        }
+        ClockDrift::recordSync(driftState, rtcUs, trueUs);
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.printf("NTP sync: RTC was off by %.3f s, drift %.1f ppm (+/- %.1f)\n",
+                (rtcUs - trueUs) * 1e-6, driftState.ppm, driftState.uncertaintyPpm);
+        }
+    } else if (ENABLE_ERROR_PRINTS) {
+        Serial.println("NTP sync timed out");
+    }
+#endif
     
-    Serial.println("\nTime configuration:");
-    Serial.printf("GMT Offset: %ld seconds (%d hours)\n", GMT_OFFSET_SEC, GMT_OFFSET_SEC/3600);
-    Serial.printf("DST Offset: %d seconds (%d hours)\n", DAYLIGHT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC/3600);
-    Serial.printf("Current time: %s\n", formatLocalTime().c_str());
+    if (ENABLE_INFO_PRINTS) {
+        Serial.println("\nTime configuration:");
+        const DeviceConfig& config = ConfigManager::get();
+        Serial.printf("GMT Offset: %ld seconds (%ld hours)\n", (long)config.gmtOffsetSec, (long)config.gmtOffsetSec/3600);
+        Serial.printf("DST Offset: %ld seconds (%ld hours)\n", (long)config.daylightOffsetSec, (long)config.daylightOffsetSec/3600);
+        Serial.printf("Current time: %s\n", formatLocalTime().c_str());
+    }
+    return synced;
 }
 
-String TimeService::formatSecondsToTime(unsigned long totalSeconds) {
+bool TimeService::waitForSync(unsigned long timeoutMs) {
+    unsigned long start = getMillis();
+    while (sntp_get_sync_status() != SNTP_SYNC_STATUS_COMPLETED) {
+        if (getMillis() - start >= timeoutMs) {
+            return false;
+        }
+        sleep(100);
+    }
+    return true;
+}
+
+time_t TimeService::getCurrentTime() {
+    time_t now = clock->now();
+    // A replay clock is exact; only the RTC drifts
+    if (clock != &systemClock) return now;
+    return (time_t)ClockDrift::correct(driftState, now);
+}
+
+bool TimeService::isSynced() {
+    if (clock != &systemClock) return true;
+    return ClockDrift::hasSync(driftState) && time(nullptr) >= MIN_VALID_TIME;
+}
+
+long TimeService::getPredictedError() {
+    if (!isSynced()) return LONG_MAX;
+    if (clock != &systemClock) return 0;
+    int64_t error = ClockDrift::predictedError(driftState, time(nullptr));
+    return error > LONG_MAX ? LONG_MAX : (long)error;
+}
+
+bool TimeService::needsSync() {
+    if (clock != &systemClock) return false;
+    // Don't keep hammering an unreachable NTP server
+    if (syncAttempted && getMillis() - lastSyncAttempt < NTP_RETRY_INTERVAL_MS) return false;
+    return getPredictedError() > TIME_SYNC_TOLERANCE_SEC;
+}
+
+void TimeService::markSyncAttempt() {
+    lastSyncAttempt = getMillis();
+    syncAttempted = true;
+}
+
+DurationString TimeService::formatSecondsToTime(unsigned long totalSeconds) {
     if (totalSeconds > 31536000) {
         totalSeconds = totalSeconds % 86400;
     }
@@ -23,27 +122,41 @@ String TimeService::formatSecondsToTime(unsigned long totalSeconds) {
     unsigned long hours = totalSeconds / 3600;
     unsigned long minutes = (totalSeconds % 3600) / 60;
     
-    return String(hours) + "h " + String(minutes) + "m";
+    DurationString result;
+    result.appendf("%luh %lum", hours, minutes);
+    return result;
 }
 
-String TimeService::formatLocalTime(time_t timestamp) {
+TimeString TimeService::formatLocalTime(time_t timestamp) {
     struct tm timeinfo;
-    char timeStringBuff[50];
-    char tzBuff[10];
+    TimeString result;
     
     if (timestamp == 0) {
         if(!getLocalTime(&timeinfo)){
-            return "Failed to obtain time";
+            result.append("Failed to obtain time");
+            return result;
         }
     } else {
         localtime_r(&timestamp, &timeinfo);
     }
     
-    strftime(timeStringBuff, sizeof(timeStringBuff), "%a, %Y-%m-%d %H:%M:%S", &timeinfo);
-    strftime(tzBuff, sizeof(tzBuff), "%z", &timeinfo);
-    return String(timeStringBuff) + " " + String(tzBuff);
+    result.appendTime("%a, %Y-%m-%d %H:%M:%S %z", &timeinfo);
+    return result;
 }
 
 void TimeService::printLocalTime(time_t timestamp) {
-    Serial.println(formatLocalTime(timestamp));
+    Serial.println(formatLocalTime(timestamp).c_str());
+}
+
+void TimeService::sleep(unsigned long ms) {
+    // Short loop delays would flood the replay timeline, so only log real waits
+    if (ms >= 1000) {
+        ReplayService::logEvent("SLEEP", "%lu ms", ms);
+    }
+    clock->sleep(ms);
+}
+
+void TimeService::lightSleep(unsigned long ms) {
+    PowerPhaseScope phase(PowerPhase::LIGHT_SLEEP);
+    clock->lightSleep(ms);
 }
@@ -2,15 +2,46 @@
 #include <Arduino.h>
 #include "time.h"
 #include "../config/config.h"
+#include "../utils/FixedString.h"
+#include "Clock.h"
+
+typedef FixedString<15> DurationString;  // "2147483647h 59m"
+typedef FixedString<39> TimeString;      // "Tue, 2025-01-21 14:30:00 -0500"
 
 class TimeService {
 public:
-    static void initialize();
-    static String formatSecondsToTime(unsigned long totalSeconds);
-    static String formatLocalTime(time_t timestamp = 0);
+    // Run SNTP once, waiting up to NTP_SYNC_TIMEOUT_MS; true once synced.
+    // SNTP is stopped again so every clock change is one the drift estimate saw.
+    static bool initialize();
+    static DurationString formatSecondsToTime(unsigned long totalSeconds);
+    static TimeString formatLocalTime(time_t timestamp = 0);
     static void printLocalTime(time_t timestamp = 0);
     
-    static time_t getCurrentTime() {
-        return time(nullptr);
+    // Swap in a VirtualClock to replay recorded data at accelerated time
+    static void setClock(Clock* newClock) { clock = newClock; }
+    
+    // Wall-clock time, corrected for the RTC drift measured across syncs
+    static time_t getCurrentTime();
+    // False until NTP has set the clock; nothing time-based should be shown before then
+    static bool isSynced();
+    // True when the clock may be off by more than TIME_SYNC_TOLERANCE_SEC and a sync is worth trying
+    static bool needsSync();
+    // Starts the NTP_RETRY_INTERVAL_MS wait; call before connecting so a failed connect counts
+    static void markSyncAttempt();
+    static long getPredictedError();
+    
+    static unsigned long getMillis() {
+        return clock->millis();
     }
+    
+    static void sleep(unsigned long ms);
+    static void lightSleep(unsigned long ms);
+
+private:
+    static bool waitForSync(unsigned long timeoutMs);
+
+    static SystemClock systemClock;
+    static Clock* clock;
+    static unsigned long lastSyncAttempt;
+    static bool syncAttempted;
 };
@@ -6,10 +6,21 @@
 
 #include "WiFiService.h"
 #include "../config/config.h"
+#include "EnergyMonitor.h"
 
 bool WiFiService::_isConnected = false;
 
 bool WiFiService::connect() {
+#ifdef REPLAY_MODE
+    // Recorded responses stand in for the network
+    _isConnected = true;
+    return true;
+#else
+    // Push mode keeps the connection up between updates
+    if (_isConnected && WiFi.status() == WL_CONNECTED) {
+        return true;
+    }
+    PowerPhaseScope phase(PowerPhase::WIFI_ASSOCIATE);
     if (ENABLE_DEBUG_PRINTS) {
         Serial.printf("Connecting to %s ", WIFI_SSID);
     }
@@ -43,6 +54,7 @@ bool WiFiService::connect() {
     
     _isConnected = true;
     return true;
+#endif
 }
 
 void WiFiService::disconnect() {
@@ -0,0 +1,140 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "ConfigManager.h"
+#include "../services/BootSequence.h"
+
+Preferences ConfigManager::preferences;
+DeviceConfig ConfigManager::active = DeviceConfig::defaults();
+DeviceConfig ConfigManager::pending = DeviceConfig::defaults();
+FixedString<63> ConfigManager::lineBuffer;
+
+void ConfigManager::initialize() {
+#ifdef REPLAY_MODE
+    // Recordings are for the compiled-in station, so replay ignores saved profiles
+#else
+    unsigned long start = micros();
+    if (!preferences.begin(CONFIG_NAMESPACE, false)) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Failed to open config namespace, using defaults");
+        }
+        return;
+    }
+
+    DeviceConfig stored;
+    size_t length = preferences.getBytes(CONFIG_KEY, &stored, sizeof(stored));
+    if (length == sizeof(stored) && stored.isValid()) {
+        active = stored;
+    } else if (length > 0) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Saved config is invalid or from another version, using defaults");
+        }
+    }
+    pending = active;
+
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("Config loaded in %lu us (%s)\n", micros() - start, length > 0 ? "saved" : "defaults");
+        print(active);
+    }
+#endif
+}
+
+void ConfigManager::pollSerial() {
+    while (Serial.available() > 0) {
+        char c = (char)Serial.read();
+        if (c == '\r') continue;
+        if (c != '\n') {
+            lineBuffer.append(c);
+            continue;
+        }
+        if (!lineBuffer.truncated() && !lineBuffer.empty()) {
+            handleCommand(lineBuffer.c_str());
+        }
+        lineBuffer.clear();
+    }
+}
+
+bool ConfigManager::handleCommand(const char* line) {
+    if (strncmp(line, "config", 6) != 0 || (line[6] != '\0' && line[6] != ' ')) return false;
+    const char* args = line + 6;
+    while (*args == ' ') args++;
+
+    if (strcmp(args, "show") == 0 || *args == '\0') {
+        print(active);
+        printPending();
+        return true;
+    }
+
+    if (strncmp(args, "set ", 4) == 0) {
+        char name[24];
+        const char* value = strchr(args + 4, ' ');
+        size_t nameLength = value ? (size_t)(value - (args + 4)) : 0;
+        if (nameLength == 0 || nameLength >= sizeof(name)) {
+            Serial.println("Usage: config set <name> <value>");
+            return true;
+        }
+        memcpy(name, args + 4, nameLength);
+        name[nameLength] = '\0';
+
+        DeviceConfig edited = pending;
+        if (!edited.setField(name, value + 1) || !edited.isValid()) {
+            Serial.printf("Invalid value for %s\n", name);
+            return true;
+        }
+        pending = edited;
+        Serial.printf("%s = %s (run \"config save\" to apply)\n", name, value + 1);
+        return true;
+    }
+
+    if (strcmp(args, "save") == 0) {
+        if (preferences.putBytes(CONFIG_KEY, &pending, sizeof(pending)) != sizeof(pending)) {
+            Serial.println("Failed to save config");
+            return true;
+        }
+        Serial.println("Config saved, restarting");
+        Serial.flush();
+        BootSequence::restart();
+        return true;
+    }
+
+    if (strcmp(args, "reset") == 0) {
+        preferences.remove(CONFIG_KEY);
+        Serial.println("Config reset to defaults, restarting");
+        Serial.flush();
+        BootSequence::restart();
+        return true;
+    }
+
+    Serial.println("Commands: config show | config set <name> <value> | config save | config reset");
+    return true;
+}
+
+void ConfigManager::print(const DeviceConfig& config) {
+    char value[32];
+    for (int i = 0; i < DeviceConfig::fieldCount(); i++) {
+        if (config.formatField(i, value, sizeof(value))) {
+            Serial.printf("  %-12s %s\n", DeviceConfig::fieldName(i), value);
+        }
+    }
+}
+
+void ConfigManager::printPending() {
+    char activeValue[32];
+    char pendingValue[32];
+    bool header = false;
+    for (int i = 0; i < DeviceConfig::fieldCount(); i++) {
+        if (!active.formatField(i, activeValue, sizeof(activeValue)) ||
+            !pending.formatField(i, pendingValue, sizeof(pendingValue)) ||
+            strcmp(activeValue, pendingValue) == 0) {
+            continue;
+        }
+        if (!header) {
+            Serial.println("Not saved (run \"config save\" to apply):");
+            header = true;
+        }
+        Serial.printf("* %-12s %s\n", DeviceConfig::fieldName(i), pendingValue);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "../models/DeviceConfig.h"
+#include "../utils/FixedString.h"
+#include "../config/config.h"
+
+// Holds the active DeviceConfig. It is loaded from NVS once at boot and
+// can be changed from the serial console:
+//   config show | config set <name> <value> | config save | config reset
+// Saved changes take effect after the restart that save and reset trigger.
+// "config show" lists the active values, then any unsaved edits.
+class ConfigManager {
+public:
+    static void initialize();
+    static const DeviceConfig& get() { return active; }
+
+    static void pollSerial();
+    static bool handleCommand(const char* line);
+
+private:
+    static void print(const DeviceConfig& config);
+    static void printPending();  // Fields "config set" changed since the last save
+
+    static Preferences preferences;
+    static DeviceConfig active;
+    static DeviceConfig pending;  // Edited by "config set" until saved
+    static FixedString<63> lineBuffer;
+};
@@ -5,53 +5,91 @@
  */
 
 #include "PreferencesManager.h"
+#include "../services/ReplayService.h"
+#include "../services/EnergyMonitor.h"
 
 Preferences PreferencesManager::preferences;
+TideJsonBuffer PreferencesManager::jsonBuffer;
 
 void PreferencesManager::initialize() {
-    Serial.println("Initializing preferences...");
+    if (ENABLE_INFO_PRINTS) {
+        Serial.println("Initializing preferences...");
+    }
     if (!preferences.begin(PREF_NAMESPACE, false)) {
-        Serial.println("Failed to initialize preferences");
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Failed to initialize preferences");
+        }
         return;
     }
-    Serial.println("Preferences initialized successfully");
+    if (ENABLE_INFO_PRINTS) {
+        Serial.println("Preferences initialized successfully");
+    }
 }
 
 bool PreferencesManager::saveTideData(const TideData& tideData) {
-    Serial.println("Attempting to save tide data...");
+    if (ENABLE_INFO_PRINTS) {
+        Serial.println("Attempting to save tide data...");
+    }
+    PowerPhaseScope phase(PowerPhase::NVS_SAVE);
     
     // Clear existing data
     preferences.clear();
     
     // Use JsonHelper to serialize
-    String jsonString = JsonHelper::serializeTideData(tideData);
-    Serial.printf("JSON string length: %d\n", jsonString.length());
+    if (!JsonHelper::serializeTideData(tideData, jsonBuffer)) {
+        if (ENABLE_ERROR_PRINTS) {
+            Serial.println("Tide data does not fit in the JSON buffer");
+        }
+        return false;
+    }
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("JSON string length: %d\n", (int)jsonBuffer.length());
+    }
     
-    if (preferences.putString(TIDE_DATA_KEY, jsonString)) {
-        Serial.println("Tide data saved to NVS successfully");
+    if (preferences.putString(TIDE_DATA_KEY, jsonBuffer.c_str())) {
+        if (ENABLE_INFO_PRINTS) {
+            Serial.println("Tide data saved to NVS successfully");
+        }
+        ReplayService::logEvent("NVS_WRITE", "%d bytes", (int)jsonBuffer.length());
         return true;
     }
     
-    Serial.println("Failed to save tide data to NVS");
+    if (ENABLE_ERROR_PRINTS) {
+        Serial.println("Failed to save tide data to NVS");
+    }
     return false;
 }
 
 bool PreferencesManager::loadTideData(TideData& tideData) {
-    Serial.println("Attempting to load tide data...");
+    if (ENABLE_INFO_PRINTS) {
+        Serial.println("Attempting to load tide data...");
+    }
+    PowerPhaseScope phase(PowerPhase::NVS_LOAD);
+    unsigned long start = micros();
     
-    String jsonString = preferences.getString(TIDE_DATA_KEY, "");
-    if (jsonString.length() == 0) {
-        Serial.println("No saved tide data found in NVS");
+    size_t length = preferences.getString(TIDE_DATA_KEY, jsonBuffer.data(), jsonBuffer.capacity() + 1);
+    if (length == 0) {
+        if (ENABLE_INFO_PRINTS) {
+            Serial.println("No saved tide data found in NVS");
+        }
         return false;
     }
+    jsonBuffer.setLength(strlen(jsonBuffer.c_str()));
     
-    Serial.printf("Loaded JSON string length: %d\n", jsonString.length());
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("Loaded JSON string length: %d\n", (int)jsonBuffer.length());
+    }
     
-    if (JsonHelper::deserializeTideData(jsonString, tideData)) {
-        Serial.println("Tide data loaded successfully");
+    if (JsonHelper::deserializeTideData(jsonBuffer.c_str(), tideData)) {
+        // Compare with "Config loaded in" to keep the profile cheaper than this restore
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.printf("Tide data loaded successfully in %lu us\n", micros() - start);
+        }
         return true;
     }
     
-    Serial.println("Failed to parse saved tide data");
+    if (ENABLE_ERROR_PRINTS) {
+        Serial.println("Failed to parse saved tide data");
+    }
     return false;
 }
@@ -13,4 +13,5 @@ public:
     
 private:
     static Preferences preferences;
+    static TideJsonBuffer jsonBuffer;  // Shared by save and load so neither touches the heap
 };
@@ -0,0 +1,237 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "TideTableStore.h"
+#include "../services/TimeService.h"
+#include "../services/EnergyMonitor.h"
+#include "ConfigManager.h"
+
+namespace {
+
+const uint32_t FILE_MAGIC = 0x46444954;  // "TIDF"
+
+struct TableFileHeader {
+    uint32_t magic;
+    TideTableInfo info;
+};
+
+}
+
+bool TideTableStore::mounted = false;
+File TideTableStore::pending;
+uint32_t TideTableStore::pendingCount = 0;
+
+bool TideTableStore::initialize() {
+    if (!mounted) {
+        mounted = LittleFS.begin(true);
+        if (!mounted) {
+            if (ENABLE_ERROR_PRINTS) {
+                Serial.println("Failed to mount LittleFS for tide tables");
+            }
+        }
+    }
+    return mounted;
+}
+
+bool TideTableStore::readInfo(TideTableInfo& info) {
+    return initialize() && readHeader(TIDE_TABLE_PATH, info);
+}
+
+// A table file is whole when its length matches the count in its header
+bool TideTableStore::readHeader(const char* path, TideTableInfo& info) {
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+    File file = LittleFS.open(path, FILE_READ);
+    TableFileHeader header;
+    bool valid = file &&
+                 file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                 header.magic == FILE_MAGIC &&
+                 file.size() == sizeof(header) + (size_t)header.info.count * sizeof(TideTableRecord);
+    file.close();
+    if (valid) {
+        info = header.info;
+    }
+    return valid;
+}
+
+bool TideTableStore::loadWindow(TideData& tideData, time_t now) {
+    PowerPhaseScope phase(PowerPhase::NVS_LOAD);
+    TideTableInfo info;
+    if (!readInfo(info) || !TideTableCodec::sameStation(info.stationId, ConfigManager::get().stationId) || now < info.baseTime) {
+        return false;
+    }
+
+    File file = LittleFS.open(TIDE_TABLE_PATH, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    // Binary search for the first extreme after now
+    uint32_t target = (uint64_t)(now - info.baseTime) > UINT32_MAX ? UINT32_MAX : (uint32_t)(now - info.baseTime);
+    uint32_t low = 0;
+    uint32_t high = info.count;
+    TideTableRecord record;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (!readRecord(file, middle, record)) {
+            file.close();
+            return false;
+        }
+        if (record.offset <= target) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    // Need the extreme we're coming from and at least one ahead
+    if (low == 0 || low >= info.count || !readRecord(file, low - 1, record)) {
+        file.close();
+        return false;
+    }
+    tideData.current.timestamp = info.baseTime + record.offset;
+    tideData.current.height = record.heightCm / 100.0f;
+    tideData.current.isHigh = record.isHigh;
+
+    tideData.extremes.clear();
+    for (uint32_t i = low; i < info.count && !tideData.extremes.full(); i++) {
+        if (!readRecord(file, i, record)) {
+            break;
+        }
+        tideData.extremes.push(info.baseTime + record.offset, record.heightCm / 100.0f, record.isHigh);
+    }
+    file.close();
+
+    tideData.type = tideData.extremes.isHigh(0) ? TideType::RISING : TideType::FALLING;
+    tideData.lastUpdateTime = now;
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("Loaded %d extremes from tide table revision %lu\n",
+            tideData.extremes.size(), (unsigned long)info.revision);
+    }
+    return true;
+}
+
+time_t TideTableStore::coverageEnd() {
+    TideTableInfo info;
+    if (!readInfo(info) || info.count == 0 || !TideTableCodec::sameStation(info.stationId, ConfigManager::get().stationId)) {
+        return 0;
+    }
+    File file = LittleFS.open(TIDE_TABLE_PATH, FILE_READ);
+    TideTableRecord record;
+    bool found = file && readRecord(file, info.count - 1, record);
+    file.close();
+    return found ? info.baseTime + record.offset : 0;
+}
+
+bool TideTableStore::beginTable(const TideTableInfo& info) {
+    if (!initialize()) {
+        return false;
+    }
+    abortTable();
+    pending = LittleFS.open(TIDE_TABLE_PENDING_PATH, FILE_WRITE);
+    if (!pending) {
+        return false;
+    }
+    TableFileHeader header;
+    header.magic = FILE_MAGIC;
+    header.info = info;
+    pendingCount = 0;
+    return pending.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+}
+
+bool TideTableStore::appendRecord(const TideTableRecord& record) {
+    if (!pending) {
+        return false;
+    }
+    pendingCount++;
+    return pending.write((const uint8_t*)&record, sizeof(record)) == sizeof(record);
+}
+
+bool TideTableStore::commitTable() {
+    if (!pending) {
+        return false;
+    }
+    pending.close();
+    // The old table stays until the new one is known whole; LittleFS renames
+    // over it in one step
+    TideTableInfo info;
+    if (!readHeader(TIDE_TABLE_PENDING_PATH, info) || info.count != pendingCount) {
+        abortTable();
+        return false;
+    }
+    return LittleFS.rename(TIDE_TABLE_PENDING_PATH, TIDE_TABLE_PATH);
+}
+
+void TideTableStore::abortTable() {
+    if (pending) {
+        pending.close();
+    }
+    if (mounted && LittleFS.exists(TIDE_TABLE_PENDING_PATH)) {
+        LittleFS.remove(TIDE_TABLE_PENDING_PATH);
+    }
+    pendingCount = 0;
+}
+
+bool TideTableStore::applyPatch(const TideTablePatchInfo& patch, const uint8_t* data) {
+    TideTableInfo info;
+    if (!readInfo(info) ||
+        !TideTableCodec::sameStation(info.stationId, patch.stationId) ||
+        info.revision != patch.fromRevision) {
+        return false;
+    }
+
+    // Entries must be in index order; new records may only be appended at the end
+    uint32_t newCount = info.count;
+    for (uint16_t i = 0; i < patch.count; i++) {
+        TideTablePatchEntry entry = TideTableCodec::patchEntry(data, i);
+        if ((i > 0 && entry.index <= TideTableCodec::patchEntry(data, i - 1).index) || entry.index > newCount) {
+            return false;
+        }
+        if (entry.index == newCount) {
+            newCount++;
+        }
+    }
+    if (newCount > TIDE_TABLE_MAX_RECORDS) {
+        return false;
+    }
+
+    // Write the patched table to the pending file so a failure leaves the old one intact
+    TideTableInfo updated = info;
+    updated.count = newCount;
+    updated.revision = patch.toRevision;
+    File source = LittleFS.open(TIDE_TABLE_PATH, FILE_READ);
+    if (!source || !beginTable(updated)) {
+        source.close();
+        return false;
+    }
+
+    uint16_t nextEntry = 0;
+    uint32_t previousOffset = 0;
+    for (uint32_t index = 0; index < newCount; index++) {
+        TideTableRecord record;
+        if (nextEntry < patch.count && TideTableCodec::patchEntry(data, nextEntry).index == index) {
+            record = TideTableCodec::patchEntry(data, nextEntry++).record;
+        } else if (!readRecord(source, index, record)) {
+            source.close();
+            abortTable();
+            return false;
+        }
+        if ((index > 0 && record.offset < previousOffset) || !appendRecord(record)) {
+            source.close();
+            abortTable();
+            return false;
+        }
+        previousOffset = record.offset;
+    }
+    source.close();
+    return commitTable();
+}
+
+bool TideTableStore::readRecord(File& file, uint32_t index, TideTableRecord& record) {
+    return file.seek(sizeof(TableFileHeader) + (size_t)index * sizeof(TideTableRecord)) &&
+           file.read((uint8_t*)&record, sizeof(record)) == sizeof(record);
+}
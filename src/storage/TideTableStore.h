@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "../models/TideData.h"
+#include "../models/TideTable.h"
+#include "../config/config.h"
+
+// Provisioned tide table in flash: a TideTableInfo header followed by
+// fixed-size TideTableRecords, so lookups can seek instead of reading it all.
+// New tables are written to a temporary file and only replace the current
+// one once their signature and length have been checked, by a rename over it,
+// so a power cut leaves either the old table or the new one.
+class TideTableStore {
+public:
+    static bool initialize();
+    static bool readInfo(TideTableInfo& info);
+    static bool loadWindow(TideData& tideData, time_t now);
+    static time_t coverageEnd();
+
+    static bool beginTable(const TideTableInfo& info);
+    static bool appendRecord(const TideTableRecord& record);
+    static bool commitTable();
+    static void abortTable();
+
+    static bool applyPatch(const TideTablePatchInfo& patch, const uint8_t* data);
+
+private:
+    static bool readHeader(const char* path, TideTableInfo& info);
+    static bool readRecord(File& file, uint32_t index, TideTableRecord& record);
+
+    static bool mounted;
+    static File pending;
+    static uint32_t pendingCount;
+};
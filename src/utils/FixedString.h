@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+// Fixed-capacity string that lives on the stack or in static storage.
+// Appends that don't fit are truncated and flagged instead of allocating.
+template <size_t Capacity>
+class FixedString {
+public:
+    FixedString() {
+        clear();
+    }
+
+    explicit FixedString(const char* text) {
+        clear();
+        append(text);
+    }
+
+    void clear() {
+        _length = 0;
+        _truncated = false;
+        _data[0] = '\0';
+    }
+
+    FixedString& append(const char* text) {
+        return append(text, strlen(text));
+    }
+
+    FixedString& append(const char* text, size_t count) {
+        if (count > Capacity - _length) {
+            count = Capacity - _length;
+            _truncated = true;
+        }
+        memcpy(_data + _length, text, count);
+        _length += count;
+        _data[_length] = '\0';
+        return *this;
+    }
+
+    FixedString& append(char c) {
+        return append(&c, 1);
+    }
+
+    __attribute__((format(printf, 2, 3)))
+    FixedString& appendf(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        size_t room = Capacity - _length;
+        int written = vsnprintf(_data + _length, room + 1, format, args);
+        va_end(args);
+        if (written < 0) {
+            _data[_length] = '\0';
+            _truncated = true;
+        } else if ((size_t)written > room) {
+            _length = Capacity;
+            _truncated = true;
+        } else {
+            _length += written;
+        }
+        return *this;
+    }
+
+    FixedString& appendTime(const char* format, const struct tm* timeinfo) {
+        size_t written = strftime(_data + _length, Capacity - _length + 1, format, timeinfo);
+        if (written == 0 && format[0] != '\0') {
+            // strftime leaves the buffer undefined when the result doesn't fit
+            _data[_length] = '\0';
+            _truncated = true;
+        }
+        _length += written;
+        return *this;
+    }
+
+    // For APIs that write into data() directly
+    void setLength(size_t length) {
+        _length = length < Capacity ? length : Capacity;
+        _data[_length] = '\0';
+    }
+
+    const char* c_str() const { return _data; }
+    char* data() { return _data; }
+    size_t length() const { return _length; }
+    bool empty() const { return _length == 0; }
+    bool truncated() const { return _truncated; }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    char _data[Capacity + 1];
+    size_t _length;
+    bool _truncated;
+};
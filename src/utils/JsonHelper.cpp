@@ -5,79 +5,140 @@
  */
 
 #include "JsonHelper.h"
+#include "../storage/ConfigManager.h"
+#include "../models/TideValidator.h"
+#include <cmath>
 
-String JsonHelper::serializeTideData(const TideData& tideData) {
-    JSONVar tideJson;
-    
-    tideJson["type"] = tideData.type;
-    tideJson["currentHeight"] = tideData.currentHeight;
-    tideJson["lastUpdateTime"] = (double)tideData.lastUpdateTime;
+TideJsonBuffer JsonHelper::inputBuffer;
+
+bool JsonHelper::serializeTideData(const TideData& tideData, TideJsonBuffer& json) {
+    json.clear();
+    json.appendf("{\"station\":\"%s\",\"type\":\"%s\",\"currentHeight\":%.6g,\"lastUpdateTime\":%lu,",
+                 ConfigManager::get().stationId, tideTypeName(tideData.type), tideData.currentHeight,
+                 tideData.lastUpdateTime);
     
     // Serialize current extreme
-    tideJson["current"] = serializeExtreme(tideData.current);
+    json.append("\"current\":");
+    serializeExtreme(tideData.current, json);
     
     // Serialize future extremes array
-    JSONVar extremesArray;
-    for(int i = 0; i < tideData.numExtremes; i++) {
-        extremesArray[i] = serializeExtreme(tideData.extremes[i]);
+    json.append(",\"extremes\":[");
+    for(int i = 0; i < tideData.extremes.size(); i++) {
+        if (i > 0) {
+            json.append(',');
+        }
+        serializeExtreme(tideData.extremes.at(i), json);
     }
-    tideJson["extremes"] = extremesArray;
-    tideJson["numExtremes"] = tideData.numExtremes;
+    json.appendf("],\"numExtremes\":%d}", tideData.extremes.size());
     
-    return JSON.stringify(tideJson);
+    return !json.truncated();
 }
 
-bool JsonHelper::deserializeTideData(const String& jsonString, TideData& tideData) {
-    if (jsonString.length() == 0) {
+bool JsonHelper::deserializeTideData(const char* jsonString, TideData& tideData) {
+    if (jsonString == nullptr || jsonString[0] == '\0') {
         return false;
     }
     
     JSONVar tideJson = JSON.parse(jsonString);
-    if (JSON.typeof(tideJson) == "undefined") {
+    if (JSON.typeof(tideJson) != "object") {
+        return false;
+    }
+    // Saved for another station, or by a version that didn't record one and
+    // stored local times
+    const char* station = (const char*)tideJson["station"];
+    if (station == nullptr || strcmp(station, ConfigManager::get().stationId) != 0) {
         return false;
     }
     
-    // Load basic data
-    tideData.type = (const char*)tideJson["type"];
-    tideData.currentHeight = (double)tideJson["currentHeight"];
-    tideData.lastUpdateTime = (unsigned long)((double)tideJson["lastUpdateTime"]);
+    // Build into a copy so a document that fails halfway leaves tideData as it was
+    TideData parsed;
+    float currentHeight;
+    double lastUpdateTime, numExtremes;
+    if (!readHeight(tideJson["currentHeight"], currentHeight) ||
+        !readNumber(tideJson["lastUpdateTime"], lastUpdateTime) || lastUpdateTime < 0 || lastUpdateTime > UINT32_MAX ||
+        !readNumber(tideJson["numExtremes"], numExtremes)) {
+        return false;
+    }
+    parsed.type = parseTideType((const char*)tideJson["type"]);
+    parsed.currentHeight = currentHeight;
+    parsed.lastUpdateTime = (unsigned long)lastUpdateTime;
     
-    // Load current extreme
-    deserializeExtreme(tideJson["current"], tideData.current);
+    if (!deserializeExtreme(tideJson["current"], parsed.current)) {
+        return false;
+    }
     
-    // Load future extremes
-    tideData.numExtremes = (int)tideJson["numExtremes"];
+    // The array decides how many extremes there are; numExtremes only has to agree with it
     JSONVar extremesArray = tideJson["extremes"];
-    for(int i = 0; i < tideData.numExtremes; i++) {
-        deserializeExtreme(extremesArray[i], tideData.extremes[i]);
+    if (JSON.typeof(extremesArray) != "array") {
+        return false;
+    }
+    int count = extremesArray.length();
+    if (count < 0 || count > TideTimeline::CAPACITY || numExtremes != count) {
+        return false;
+    }
+    for(int i = 0; i < count; i++) {
+        TideExtreme extreme;
+        if (!deserializeExtreme(extremesArray[i], extreme) || !parsed.extremes.push(extreme)) {
+            return false;
+        }
     }
     
+    tideData = parsed;
     return true;
 }
 
-JSONVar JsonHelper::serializeExtreme(const TideExtreme& extreme) {
-    JSONVar jsonExtreme;
-    time_t timestamp = extreme.timestamp;
-    adjustTimestampForTimezone(timestamp, true);
-    
-    jsonExtreme["timestamp"] = (double)timestamp;
-    jsonExtreme["height"] = extreme.height;
-    jsonExtreme["isHigh"] = extreme.isHigh;
-    
-    return jsonExtreme;
+bool JsonHelper::deserializeTideData(const char* data, size_t length, TideData& tideData) {
+    // JSON.parse needs a terminated string, and an embedded NUL would hide the rest
+    if (data == nullptr || length > TideJsonBuffer::capacity() || memchr(data, '\0', length) != nullptr) {
+        return false;
+    }
+    inputBuffer.clear();
+    inputBuffer.append(data, length);
+    return deserializeTideData(inputBuffer.c_str(), tideData);
 }
 
-void JsonHelper::deserializeExtreme(const JSONVar& jsonExtreme, TideExtreme& extreme) {
-    extreme.timestamp = (time_t)((double)jsonExtreme["timestamp"]);
-    adjustTimestampForTimezone(extreme.timestamp, false);
-    extreme.height = (double)jsonExtreme["height"];
-    extreme.isHigh = (bool)jsonExtreme["isHigh"];
+bool JsonHelper::readNumber(const JSONVar& value, double& out) {
+    if (JSON.typeof(value) != "number") {
+        return false;
+    }
+    double number = (double)value;
+    if (!std::isfinite(number)) {
+        return false;
+    }
+    out = number;
+    return true;
 }
 
-void JsonHelper::adjustTimestampForTimezone(time_t& timestamp, bool toUTC) {
-    if (toUTC) {
-        timestamp += GMT_OFFSET_SEC + DAYLIGHT_OFFSET_SEC;
-    } else {
-        timestamp -= GMT_OFFSET_SEC + DAYLIGHT_OFFSET_SEC;
+bool JsonHelper::readHeight(const JSONVar& value, float& out) {
+    double height;
+    if (!readNumber(value, height) ||
+        height < DEFAULT_VALIDATION_LIMITS.minHeight || height > DEFAULT_VALIDATION_LIMITS.maxHeight) {
+        return false;
     }
+    out = height;
+    return true;
+}
+
+void JsonHelper::serializeExtreme(const TideExtreme& extreme, TideJsonBuffer& json) {
+    json.appendf("{\"timestamp\":%lld,\"height\":%.6g,\"isHigh\":%s}",
+                 (long long)extreme.timestamp, extreme.height, extreme.isHigh ? "true" : "false");
+}
+
+bool JsonHelper::deserializeExtreme(const JSONVar& jsonExtreme, TideExtreme& extreme) {
+    double timestamp;
+    float height;
+    if (JSON.typeof(jsonExtreme) != "object" ||
+        !readNumber(jsonExtreme["timestamp"], timestamp) ||
+        !readHeight(jsonExtreme["height"], height) ||
+        JSON.typeof(jsonExtreme["isHigh"]) != "boolean") {
+        return false;
+    }
+    // Outside this range the conversion to time_t is undefined
+    if (fabs(timestamp) > 4e9) {
+        return false;
+    }
+    extreme.timestamp = (time_t)timestamp;
+    extreme.height = height;
+    extreme.isHigh = (bool)jsonExtreme["isHigh"];
+    return true;
 }
@@ -3,14 +3,31 @@
 #include <Arduino_JSON.h>
 #include "../models/TideData.h"
 #include "../config/config.h"
+#include "FixedString.h"
+
+// Large enough for MAX_EXTREMES serialized extremes plus the header fields
+typedef FixedString<2047> TideJsonBuffer;
 
 class JsonHelper {
 public:
-    static String serializeTideData(const TideData& tideData);
-    static bool deserializeTideData(const String& jsonString, TideData& tideData);
+    // Timestamps are saved in UTC, with the station they were fetched for
+    static bool serializeTideData(const TideData& tideData, TideJsonBuffer& json);
+    // Untrusted input: checks every type and bound, and leaves tideData
+    // untouched unless the whole document is usable and for this station
+    static bool deserializeTideData(const char* jsonString, TideData& tideData);
+    // For input that is not NUL terminated, such as a fuzzer's buffer
+    static bool deserializeTideData(const char* data, size_t length, TideData& tideData);
+
+    // True and sets out only if value is a finite JSON number
+    static bool readNumber(const JSONVar& value, double& out);
+    // As readNumber, but also within the validator's height limits, so the
+    // conversion to float is defined and a restore keeps only what a fetch
+    // could have stored
+    static bool readHeight(const JSONVar& value, float& out);
     
 private:
-    static JSONVar serializeExtreme(const TideExtreme& extreme);
-    static void deserializeExtreme(const JSONVar& jsonExtreme, TideExtreme& extreme);
-    static void adjustTimestampForTimezone(time_t& timestamp, bool toUTC);
+    static void serializeExtreme(const TideExtreme& extreme, TideJsonBuffer& json);
+    static bool deserializeExtreme(const JSONVar& jsonExtreme, TideExtreme& extreme);
+
+    static TideJsonBuffer inputBuffer;
 };
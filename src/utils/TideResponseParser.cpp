@@ -0,0 +1,117 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "TideResponseParser.h"
+#include "JsonHelper.h"
+
+TideCandidates TideResponseParser::candidates;
+
+bool TideResponseParser::parse(const char* payload, TideData& tideData, time_t now) {
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.println("Parsing JSON...");
+    }
+    JSONVar doc = JSON.parse(payload);
+    if (JSON.typeof(doc) == "undefined") {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.println("JSON parsing failed");
+        }
+        return false;
+    }
+
+    // Navigate through GraphQL response structure
+    if (!doc.hasOwnProperty("data") || !doc["data"].hasOwnProperty("tides")) {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.println("Invalid GraphQL response structure");
+        }
+        return false;
+    }
+
+    JSONVar tides = doc["data"]["tides"];
+    if (!tides.hasOwnProperty("extremes")) {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.println("No extremes data in response");
+        }
+        return false;
+    }
+
+    // Validate before touching tideData, so a bad response never replaces good data
+    JSONVar extremes = tides["extremes"];
+    if (!collectExtremes(extremes, candidates)) {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.println("Rejected tide data: malformed extremes");
+        }
+        return false;
+    }
+    TideCheck check = TideValidator::validate(candidates, now);
+    if (check != TideCheck::OK) {
+        if (ENABLE_DEBUG_PRINTS) {
+            Serial.printf("Rejected tide data: %s\n", tideCheckName(check));
+        }
+        return false;
+    }
+
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.println("Updating tide data...");
+    }
+    tideData.type = parseTideType((const char*)tides["tideType"]);
+    tideData.lastUpdateTime = now;
+    publishExtremes(candidates, tideData, now);
+    float waterLevel;
+    if (JsonHelper::readHeight(tides["waterLevel"], waterLevel)) {
+        tideData.observeLevel(now, waterLevel);  // After publishing, so it blends against the new extremes
+    } else {
+        tideData.currentHeight = 0;
+    }
+
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.println("Tide data fetch completed successfully");
+    }
+    return true;
+}
+
+bool TideResponseParser::collectExtremes(JSONVar& extremes, TideCandidates& candidates) {
+    candidates.clear();
+    if (JSON.typeof(extremes) != "array") {
+        return false;
+    }
+    int count = extremes.length();
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("Processing %d extremes...\n", count);
+    }
+    for (int i = 0; i < count; i++) {
+        double timestampMs;
+        float height;
+        if (!JsonHelper::readNumber(extremes[i]["timestamp"], timestampMs) ||
+            !JsonHelper::readHeight(extremes[i]["height"], height) ||
+            timestampMs <= 0 || timestampMs > 4e12) {  // Keeps the time_t conversion defined
+            return false;
+        }
+        candidates.add((time_t)(timestampMs / 1000), height, isHighExtreme(extremes[i]));
+    }
+    return true;
+}
+
+void TideResponseParser::publishExtremes(const TideCandidates& candidates, TideData& tideData, time_t now) {
+    // Validated candidates are sorted, so the last one at or before now is the current extreme
+    tideData.extremes.clear();
+    for (int i = 0; i < candidates.count; i++) {
+        const TideExtreme& extreme = candidates.items[i];
+        if (extreme.timestamp <= now) {
+            tideData.current = extreme;
+        } else if (!tideData.extremes.push(extreme)) {
+            break;  // Full
+        }
+    }
+    if (ENABLE_DEBUG_PRINTS) {
+        Serial.printf("Stored %d future extremes\n", tideData.extremes.size());
+    }
+}
+
+bool TideResponseParser::isHighExtreme(JSONVar extreme) {
+    // Points into the parsed document, so no String is allocated
+    const char* type = (const char*)extreme["type"];
+    return type != nullptr && strstr(type, "HIGH") != nullptr;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+#include <Arduino_JSON.h>
+#include "../models/TideData.h"
+#include "../models/TideValidator.h"
+#include "../config/config.h"
+
+// Reads the tide API's GraphQL response into TideData. Untrusted input:
+// the extremes are validated before tideData is touched, so a bad response
+// never replaces good data. Kept apart from TideService's networking so the
+// host tools can feed it directly.
+class TideResponseParser {
+public:
+    static bool parse(const char* payload, TideData& tideData, time_t now);
+
+private:
+    static bool collectExtremes(JSONVar& extremes, TideCandidates& candidates);
+    static void publishExtremes(const TideCandidates& candidates, TideData& tideData, time_t now);
+    static bool isHighExtreme(JSONVar extreme);
+
+    static TideCandidates candidates;  // Static so a response is staged without using the stack
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+// Command-line options, --name value
+typedef std::map<std::string, std::string> Options;
+
+inline std::string require(const Options& options, const char* name) {
+    Options::const_iterator it = options.find(name);
+    if (it == options.end()) {
+        throw std::runtime_error(std::string("missing --") + name);
+    }
+    return it->second;
+}
+
+inline std::string optional(const Options& options, const char* name, const char* fallback) {
+    Options::const_iterator it = options.find(name);
+    return it == options.end() ? fallback : it->second;
+}
+
+// Everything after argv[1], the command
+inline bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 2; i < argc; i += 2) {
+        if (strncmp(argv[i], "--", 2) != 0 || i + 1 >= argc) {
+            return false;
+        }
+        options[argv[i] + 2] = argv[i + 1];
+    }
+    return true;
+}
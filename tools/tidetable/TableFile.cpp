@@ -0,0 +1,426 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "TableFile.h"
+#include <fcntl.h>
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/pem.h>
+#include <openssl/sha.h>
+#include <openssl/x509.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const size_t SIGNATURE_HALF = TIDE_TABLE_SIGNATURE_SIZE / 2;
+
+// The HMAC-SHA256 generator of RFC 6979 section 3.2, seeded with the private
+// key and the reduced digest. Each call to next gives the following candidate
+// for k; the caller skips any outside [1, n).
+class Rfc6979Nonce {
+public:
+    Rfc6979Nonce(const unsigned char (&key)[SIGNATURE_HALF], const unsigned char (&digest)[SIGNATURE_HALF]) {
+        memset(_v, 0x01, sizeof(_v));
+        memset(_k, 0x00, sizeof(_k));
+        reseed(0x00, key, digest);
+        reseed(0x01, key, digest);
+    }
+    ~Rfc6979Nonce() {
+        OPENSSL_cleanse(_k, sizeof(_k));
+        OPENSSL_cleanse(_v, sizeof(_v));
+    }
+
+    void next(unsigned char (&candidate)[SIGNATURE_HALF]) {
+        if (_started) {
+            // The previous candidate was unusable
+            reseed(0x00, nullptr, nullptr);
+        }
+        _started = true;
+        mac(_v, { { _v, sizeof(_v) } });
+        memcpy(candidate, _v, sizeof(candidate));
+    }
+
+private:
+    struct Part {
+        const unsigned char* data;
+        size_t length;
+    };
+
+    void mac(unsigned char (&out)[SIGNATURE_HALF], std::initializer_list<Part> parts) {
+        std::vector<unsigned char> message;
+        for (const Part& part : parts) {
+            message.insert(message.end(), part.data, part.data + part.length);
+        }
+        unsigned int length = sizeof(out);
+        HMAC(EVP_sha256(), _k, sizeof(_k), message.data(), message.size(), out, &length);
+        OPENSSL_cleanse(message.data(), message.size());
+    }
+
+    // K = HMAC_K(V || separator [|| key || digest]), V = HMAC_K(V)
+    void reseed(unsigned char separator, const unsigned char* key, const unsigned char* digest) {
+        unsigned char k[SIGNATURE_HALF];
+        if (key != nullptr) {
+            mac(k, { { _v, sizeof(_v) }, { &separator, 1 }, { key, SIGNATURE_HALF }, { digest, SIGNATURE_HALF } });
+        } else {
+            mac(k, { { _v, sizeof(_v) }, { &separator, 1 } });
+        }
+        memcpy(_k, k, sizeof(_k));
+        OPENSSL_cleanse(k, sizeof(k));
+        mac(_v, { { _v, sizeof(_v) } });
+    }
+
+    unsigned char _k[SIGNATURE_HALF];
+    unsigned char _v[SIGNATURE_HALF];
+    bool _started = false;
+};
+
+class Collector : public TideTableDecoder::Listener {
+public:
+    explicit Collector(TableContents& table) : table(table) {}
+
+    void onSignedBytes(const uint8_t*, size_t) override {}
+
+    bool onHeader(const TideTableInfo& info) override {
+        table.info = info;
+        table.records.clear();
+        table.records.reserve(info.count);
+        return true;
+    }
+
+    bool onRecord(const TideTableRecord& record) override {
+        table.records.push_back(record);
+        return true;
+    }
+
+private:
+    TableContents& table;
+};
+
+}
+
+SigningKey SigningKey::generate() {
+    EVP_PKEY* key = nullptr;
+    EVP_PKEY_CTX* context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    bool generated = context != nullptr &&
+                     EVP_PKEY_keygen_init(context) == 1 &&
+                     EVP_PKEY_CTX_set_ec_paramgen_curve_nid(context, NID_X9_62_prime256v1) == 1 &&
+                     EVP_PKEY_keygen(context, &key) == 1;
+    EVP_PKEY_CTX_free(context);
+    if (!generated) {
+        throw std::runtime_error("failed to generate a key");
+    }
+    return SigningKey(key);
+}
+
+SigningKey SigningKey::load(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        throw std::runtime_error("cannot read " + path);
+    }
+    EVP_PKEY* key = PEM_read_PrivateKey(file, nullptr, nullptr, nullptr);
+    fclose(file);
+    SigningKey loaded(key);
+    if (key == nullptr || EVP_PKEY_base_id(key) != EVP_PKEY_EC || EVP_PKEY_bits(key) != 256) {
+        throw std::runtime_error(path + ": not a P-256 private key from tidetable keygen");
+    }
+    return loaded;
+}
+
+SigningKey::SigningKey(SigningKey&& other) : _key(other._key) {
+    other._key = nullptr;
+}
+
+SigningKey::~SigningKey() {
+    EVP_PKEY_free(_key);
+}
+
+bool SigningKey::save(const std::string& path) const {
+    int descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (descriptor < 0) {
+        return false;
+    }
+    FILE* file = fdopen(descriptor, "w");
+    if (file == nullptr) {
+        close(descriptor);
+        return false;
+    }
+    bool written = PEM_write_PrivateKey(file, _key, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+    return fclose(file) == 0 && written;
+}
+
+std::vector<uint8_t> SigningKey::publicKey() const {
+    unsigned char* point = nullptr;
+    int length = i2d_PublicKey(_key, &point);
+    std::vector<uint8_t> bytes;
+    if (length > 0) {
+        bytes.assign(point, point + length);
+    }
+    OPENSSL_free(point);
+    return bytes;
+}
+
+bool SigningKey::sign(const uint8_t* data, size_t length, uint8_t (&signature)[TIDE_TABLE_SIGNATURE_SIZE]) const {
+    // ECDSA with the nonce derived from the key and digest as RFC 6979
+    // describes, so the same bytes always sign the same way. OpenSSL only
+    // offers that from 3.2, so the arithmetic is done here.
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(data, length, digest);
+
+    BIGNUM* d = nullptr;
+    if (EVP_PKEY_get_bn_param(_key, OSSL_PKEY_PARAM_PRIV_KEY, &d) != 1) {
+        return false;
+    }
+    BN_set_flags(d, BN_FLG_CONSTTIME);
+    EC_GROUP* group = EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1);
+    BN_CTX* context = BN_CTX_new();
+    EC_POINT* point = group != nullptr ? EC_POINT_new(group) : nullptr;
+    BIGNUM* e = BN_bin2bn(digest, sizeof(digest), nullptr);
+    BIGNUM* k = BN_new();
+    BIGNUM* r = BN_new();
+    BIGNUM* s = BN_new();
+    BIGNUM* kInverse = BN_new();
+    bool done = false;
+
+    if (point != nullptr && context != nullptr && e != nullptr && k != nullptr && r != nullptr && s != nullptr &&
+        kInverse != nullptr) {
+        const BIGNUM* n = EC_GROUP_get0_order(group);
+        BN_set_flags(k, BN_FLG_CONSTTIME);
+        // With a 256-bit digest and order, bits2int is the digest itself and
+        // bits2octets is the digest reduced once
+        unsigned char x[SIGNATURE_HALF];
+        unsigned char h[SIGNATURE_HALF];
+        bool ready = BN_bn2binpad(d, x, sizeof(x)) == (int)sizeof(x) && BN_nnmod(r, e, n, context) == 1 &&
+                     BN_bn2binpad(r, h, sizeof(h)) == (int)sizeof(h);
+        Rfc6979Nonce nonce(x, h);
+        OPENSSL_cleanse(x, sizeof(x));
+
+        while (ready && !done) {
+            unsigned char candidate[SIGNATURE_HALF];
+            nonce.next(candidate);
+            ready = BN_bin2bn(candidate, sizeof(candidate), k) != nullptr;
+            OPENSSL_cleanse(candidate, sizeof(candidate));
+            if (!ready || BN_is_zero(k) || BN_cmp(k, n) >= 0) {
+                continue;
+            }
+            // r = x(kG) mod n, s = k^-1 (e + r d) mod n
+            ready = EC_POINT_mul(group, point, k, nullptr, nullptr, context) == 1 &&
+                    EC_POINT_get_affine_coordinates(group, point, r, nullptr, context) == 1 &&
+                    BN_nnmod(r, r, n, context) == 1 && BN_mod_inverse(kInverse, k, n, context) != nullptr &&
+                    BN_mod_mul(s, r, d, n, context) == 1 && BN_mod_add(s, s, e, n, context) == 1 &&
+                    BN_mod_mul(s, s, kInverse, n, context) == 1;
+            done = ready && !BN_is_zero(r) && !BN_is_zero(s);
+        }
+        done = done && BN_bn2binpad(r, signature, SIGNATURE_HALF) == (int)SIGNATURE_HALF &&
+               BN_bn2binpad(s, signature + SIGNATURE_HALF, SIGNATURE_HALF) == (int)SIGNATURE_HALF;
+    }
+
+    BN_clear_free(kInverse);
+    BN_free(s);
+    BN_free(r);
+    BN_clear_free(k);
+    BN_free(e);
+    EC_POINT_free(point);
+    BN_CTX_free(context);
+    EC_GROUP_free(group);
+    BN_clear_free(d);
+    return done;
+}
+
+bool SigningKey::verify(const uint8_t* data, size_t length, const uint8_t* signature) const {
+    ECDSA_SIG* parsed = ECDSA_SIG_new();
+    BIGNUM* r = BN_bin2bn(signature, SIGNATURE_HALF, nullptr);
+    BIGNUM* s = BN_bin2bn(signature + SIGNATURE_HALF, SIGNATURE_HALF, nullptr);
+    if (parsed == nullptr || r == nullptr || s == nullptr || ECDSA_SIG_set0(parsed, r, s) != 1) {
+        BN_free(r);
+        BN_free(s);
+        ECDSA_SIG_free(parsed);
+        return false;
+    }
+    unsigned char* der = nullptr;
+    int derLength = i2d_ECDSA_SIG(parsed, &der);
+    ECDSA_SIG_free(parsed);
+
+    EVP_MD_CTX* context = EVP_MD_CTX_new();
+    bool valid = derLength > 0 && context != nullptr &&
+                 EVP_DigestVerifyInit(context, nullptr, EVP_sha256(), nullptr, _key) == 1 &&
+                 EVP_DigestVerify(context, der, (size_t)derLength, data, length) == 1;
+    EVP_MD_CTX_free(context);
+    OPENSSL_free(der);
+    return valid;
+}
+
+void appendSignature(std::vector<uint8_t>& bytes, const SigningKey& key) {
+    uint8_t signature[TIDE_TABLE_SIGNATURE_SIZE];
+    if (!key.sign(bytes.data(), bytes.size(), signature)) {
+        throw std::runtime_error("signing failed");
+    }
+    bytes.insert(bytes.end(), signature, signature + sizeof(signature));
+}
+
+bool verifySignature(const std::vector<uint8_t>& bytes, const SigningKey& key) {
+    if (bytes.size() < TIDE_TABLE_SIGNATURE_SIZE) {
+        return false;
+    }
+    size_t signedLength = bytes.size() - TIDE_TABLE_SIGNATURE_SIZE;
+    return key.verify(bytes.data(), signedLength, bytes.data() + signedLength);
+}
+
+bool encodeSignedTable(const TableContents& table, const SigningKey& key, std::vector<uint8_t>& out) {
+    VectorSink sink;
+    if (table.records.size() != table.info.count ||
+        !TideTableCodec::encodeTable(table.info, table.records.data(), sink)) {
+        return false;
+    }
+    appendSignature(sink.bytes, key);
+    out.swap(sink.bytes);
+    return true;
+}
+
+bool decodeSignedTable(const std::vector<uint8_t>& bytes, const SigningKey& key, TableContents& table, std::string& error) {
+    if (!verifySignature(bytes, key)) {
+        error = "signature mismatch";
+        return false;
+    }
+    Collector collector(table);
+    TideTableDecoder decoder(collector);
+    if (!decoder.feed(bytes.data(), bytes.size()) || !decoder.finished()) {
+        error = "malformed table";
+        return false;
+    }
+    return true;
+}
+
+std::vector<TideExtreme> tableExtremes(const TableContents& table) {
+    std::vector<TideExtreme> extremes;
+    for (size_t i = 0; i < table.records.size(); i++) {
+        TideExtreme extreme;
+        extreme.timestamp = (time_t)(table.info.baseTime + table.records[i].offset);
+        extreme.height = table.records[i].heightCm / 100.0f;
+        extreme.isHigh = table.records[i].isHigh;
+        extremes.push_back(extreme);
+    }
+    return extremes;
+}
+
+size_t extremeAfter(const std::vector<TideExtreme>& extremes, time_t time) {
+    return std::upper_bound(extremes.begin(), extremes.end(), time,
+        [](time_t t, const TideExtreme& e) { return t < e.timestamp; }) - extremes.begin();
+}
+
+bool readExtremesCsv(const std::string& path, TableContents& table, std::string& error) {
+    // One extreme per line: epoch_seconds,height_meters,H|L
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    table.records.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string timeField, heightField, typeField;
+        if (!std::getline(fields, timeField, ',') || !std::getline(fields, heightField, ',') ||
+            !std::getline(fields, typeField, ',')) {
+            error = path + ":" + std::to_string(lineNumber) + ": expected time,height,type";
+            return false;
+        }
+
+        int64_t timestamp = std::stoll(timeField);
+        if (table.records.empty()) {
+            table.info.baseTime = timestamp;
+        }
+        int64_t offset = timestamp - table.info.baseTime;
+        long heightCm = std::lround(std::stod(heightField) * 100.0);
+        if (offset < 0 || offset > UINT32_MAX ||
+            (!table.records.empty() && (uint32_t)offset < table.records.back().offset)) {
+            error = path + ":" + std::to_string(lineNumber) + ": extremes must be in time order";
+            return false;
+        }
+        if (heightCm < INT16_MIN || heightCm > INT16_MAX) {
+            error = path + ":" + std::to_string(lineNumber) + ": height out of range";
+            return false;
+        }
+
+        TideTableRecord record;
+        record.offset = (uint32_t)offset;
+        record.heightCm = (int16_t)heightCm;
+        record.isHigh = (typeField.find('H') != std::string::npos) ? 1 : 0;
+        record.reserved = 0;
+        table.records.push_back(record);
+    }
+    if (table.records.size() > TIDE_TABLE_MAX_RECORDS) {
+        error = "too many extremes for one table";
+        return false;
+    }
+    table.info.count = (uint32_t)table.records.size();
+    return true;
+}
+
+bool readLevelsCsv(const std::string& path, std::vector<ObservedLevel>& levels, std::string& error) {
+    // One reading per line: epoch_seconds,height_meters
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    levels.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string timeField, heightField;
+        if (!std::getline(fields, timeField, ',') || !std::getline(fields, heightField, ',')) {
+            error = path + ":" + std::to_string(lineNumber) + ": expected time,height";
+            return false;
+        }
+        ObservedLevel level;
+        level.timestamp = std::stoll(timeField);
+        level.height = std::stof(heightField);
+        if (!levels.empty() && level.timestamp < levels.back().timestamp) {
+            error = path + ":" + std::to_string(lineNumber) + ": readings must be in time order";
+            return false;
+        }
+        levels.push_back(level);
+    }
+    return true;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream out(path, std::ios::binary);
+    out.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+    return (bool)out;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "models/TideTable.h"
+#include "models/TideTimeline.h"
+
+// Host-side helpers around the firmware's TideTableCodec: signing, reading
+// signed files back, and CSV input.
+
+struct evp_pkey_st;
+
+// The ECDSA P-256 key tables, patches and level readings are signed with,
+// kept in a PEM file. Devices hold only its public half.
+class SigningKey {
+public:
+    static SigningKey generate();
+    static SigningKey load(const std::string& path);  // Throws if unreadable or not P-256
+    SigningKey(SigningKey&& other);
+    ~SigningKey();
+    SigningKey(const SigningKey&) = delete;
+    SigningKey& operator=(const SigningKey&) = delete;
+
+    bool save(const std::string& path) const;  // Owner-only, and never over an existing file
+    std::vector<uint8_t> publicKey() const;    // As TIDE_TABLE_PUBLIC_KEY holds it
+
+    // Raw r||s, as the firmware reads it. The nonce is derived from the key
+    // and digest (RFC 6979), so the same bytes always give the same signature.
+    bool sign(const uint8_t* data, size_t length, uint8_t (&signature)[TIDE_TABLE_SIGNATURE_SIZE]) const;
+    bool verify(const uint8_t* data, size_t length, const uint8_t* signature) const;
+
+private:
+    explicit SigningKey(evp_pkey_st* key) : _key(key) {}
+
+    evp_pkey_st* _key;
+};
+
+struct TableContents {
+    TideTableInfo info;
+    std::vector<TideTableRecord> records;
+};
+
+class VectorSink : public TideTableSink {
+public:
+    void write(const uint8_t* data, size_t length) override {
+        bytes.insert(bytes.end(), data, data + length);
+    }
+
+    std::vector<uint8_t> bytes;
+};
+
+void appendSignature(std::vector<uint8_t>& bytes, const SigningKey& key);
+bool verifySignature(const std::vector<uint8_t>& bytes, const SigningKey& key);
+
+bool encodeSignedTable(const TableContents& table, const SigningKey& key, std::vector<uint8_t>& out);
+bool decodeSignedTable(const std::vector<uint8_t>& bytes, const SigningKey& key, TableContents& table, std::string& error);
+
+// A gauge reading, for replaying observed series against a prediction
+struct ObservedLevel {
+    int64_t timestamp;
+    float height;
+};
+
+std::vector<TideExtreme> tableExtremes(const TableContents& table);
+// Index of the first extreme after time, or extremes.size()
+size_t extremeAfter(const std::vector<TideExtreme>& extremes, time_t time);
+
+bool readExtremesCsv(const std::string& path, TableContents& table, std::string& error);
+bool readLevelsCsv(const std::string& path, std::vector<ObservedLevel>& levels, std::string& error);
+bool readFile(const std::string& path, std::vector<uint8_t>& bytes);
+bool writeFile(const std::string& path, const std::vector<uint8_t>& bytes);
@@ -0,0 +1,85 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ */
+
+#include "WorkStealingPool.h"
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(unsigned threads) :
+    _threads(threads > 0 ? threads : 1),
+    _queues(_threads),
+    _steals(0) {
+}
+
+void WorkStealingPool::run(size_t count, const std::function<void(size_t)>& task) {
+    _error = nullptr;
+    _steals = 0;
+    for (unsigned t = 0; t < _threads; t++) {
+        Queue& queue = _queues[t];
+        queue.items.clear();
+        for (size_t i = count * t / _threads; i < count * (t + 1) / _threads; i++) {
+            queue.items.push_back(i);
+        }
+    }
+
+    // The calling thread is worker 0
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < _threads; t++) {
+        workers.emplace_back(&WorkStealingPool::work, this, t, std::cref(task));
+    }
+    work(0, task);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (_error) {
+        std::rethrow_exception(_error);
+    }
+}
+
+void WorkStealingPool::work(unsigned self, const std::function<void(size_t)>& task) {
+    size_t item;
+    while (take(self, item) || steal(self, item)) {
+        {
+            std::lock_guard<std::mutex> lock(_errorMutex);
+            if (_error) return;
+        }
+        try {
+            task(item);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(_errorMutex);
+            if (!_error) {
+                _error = std::current_exception();
+            }
+        }
+    }
+}
+
+bool WorkStealingPool::take(unsigned self, size_t& item) {
+    Queue& queue = _queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.items.empty()) {
+        return false;
+    }
+    item = queue.items.front();
+    queue.items.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(unsigned self, size_t& item) {
+    // Queues only shrink during a run, so one pass that finds nothing means
+    // there is nothing left to do
+    for (unsigned i = 1; i < _threads; i++) {
+        Queue& victim = _queues[(self + i) % _threads];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty()) {
+            item = victim.items.back();
+            victim.items.pop_back();
+            std::lock_guard<std::mutex> errorLock(_errorMutex);
+            _steals++;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Runs a batch of independent tasks across a fixed number of threads. Each
+// thread starts with its own contiguous share of the task indices and works
+// through it from the front; a thread that runs dry steals from the back of
+// another's queue, so one slow station doesn't leave the rest idle. Results
+// must go to per-index slots, which keeps output independent of scheduling.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threads);
+
+    // Calls task(i) for every i in [0, count) and returns when all are done.
+    // The first exception thrown by a task is rethrown here.
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+    unsigned threads() const { return _threads; }
+    size_t steals() const { return _steals; }  // In the last run
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+
+    void work(unsigned self, const std::function<void(size_t)>& task);
+    bool take(unsigned self, size_t& item);
+    bool steal(unsigned self, size_t& item);
+
+    unsigned _threads;
+    std::vector<Queue> _queues;
+    std::mutex _errorMutex;
+    std::exception_ptr _error;
+    size_t _steals;
+};
@@ -0,0 +1,64 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "TableChecks.h"
+
+namespace {
+
+struct Decoded {
+    bool ok;
+    bool finished;
+    CheckingListener listener;
+};
+
+Decoded decode(const uint8_t* data, size_t size, size_t chunk) {
+    Decoded result;
+    TideTableDecoder decoder(result.listener);
+    result.ok = true;
+    for (size_t offset = 0; result.ok && offset < size; offset += chunk) {
+        result.ok = decoder.feed(data + offset, std::min(chunk, size - offset));
+    }
+    result.finished = decoder.finished();
+    return result;
+}
+
+}
+
+// The streaming table decoder, fed as ProvisioningService feeds it and a
+// byte at a time, which must agree; then the same bytes as a patch and as a
+// level reading
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    Decoded chunked = decode(data, size, 256);  // ProvisioningService's buffer
+    Decoded bytewise = decode(data, size, 1);
+    // A failed feed stops short of reporting its chunk, and the download is
+    // discarded, so only successful decodes have to agree beyond the verdict
+    CheckingListener::check(chunked.ok == bytewise.ok, "verdict depends on how the stream was split");
+    CheckingListener::check(!chunked.ok || (chunked.finished == bytewise.finished &&
+                                            chunked.listener.records == bytewise.listener.records &&
+                                            chunked.listener.signedBytes == bytewise.listener.signedBytes),
+        "result depends on how the stream was split");
+    if (chunked.ok && chunked.finished) {
+        CheckingListener::check(chunked.listener.records == chunked.listener.count, "finished short of the count");
+        CheckingListener::check(chunked.listener.signedBytes + TIDE_TABLE_SIGNATURE_SIZE == size,
+            "signed bytes and signature do not add up to the stream");
+    }
+
+    TideTablePatchInfo patch;
+    if (TideTableCodec::parsePatch(data, size, patch)) {
+        for (uint16_t e = 0; e < patch.count; e++) {
+            TideTableCodec::patchEntry(data, e);
+        }
+    }
+    TideLevelReading reading;
+    if (TideTableCodec::parseLevel(data, size, reading)) {
+        CheckingListener::check(reading.stationId[TIDE_TABLE_STATION_ID_SIZE - 1] == '\0', "level station id not terminated");
+    }
+    return 0;
+}
@@ -0,0 +1,18 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include "FirmwareChecks.h"
+
+// Saved state through JsonHelper::deserializeTideData, straight from the
+// fuzzer's buffer, which is not NUL terminated
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    TideData tideData;
+    checkRestore((const char*)data, size, tideData);
+    return 0;
+}
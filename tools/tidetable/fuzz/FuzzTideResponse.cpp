@@ -0,0 +1,23 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "FirmwareChecks.h"
+#include "FirmwareHost.h"
+
+// API responses through TideResponseParser and the validator behind it, at
+// the time the seed responses were recorded for
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const time_t NOW = 1760000000;
+    setHostTime(NOW);
+    std::string text((const char*)data, size);  // The HTTP client hands over a String
+    TideData tideData;
+    checkResponse(text.c_str(), tideData, NOW);
+    return 0;
+}
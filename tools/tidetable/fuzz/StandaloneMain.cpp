@@ -0,0 +1,44 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// Without libFuzzer, runs a target once over every file named or in a named
+// directory, so the corpus is replayed on compilers that lack it
+int main(int argc, char** argv) {
+    namespace fs = std::filesystem;
+    std::vector<fs::path> inputs;
+    for (int i = 1; i < argc; i++) {
+        if (fs::is_directory(argv[i])) {
+            for (const fs::directory_entry& entry : fs::directory_iterator(argv[i])) {
+                inputs.push_back(entry.path());
+            }
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    for (const fs::path& input : inputs) {
+        std::ifstream in(input, std::ios::binary);
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        try {
+            LLVMFuzzerTestOneInput(bytes.data(), bytes.size());
+        } catch (const std::exception& e) {
+            fprintf(stderr, "%s: %s\n", input.string().c_str(), e.what());
+            return 1;
+        }
+    }
+    printf("%zu inputs ran clean\n", inputs.size());
+    return 0;
+}
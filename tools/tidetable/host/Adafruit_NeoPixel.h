@@ -0,0 +1,38 @@
+#pragma once
+// Stand-in for the NeoPixel driver. show() records the colour and when it
+// went out, so checks can time how long an update takes to reach the LED.
+#include <chrono>
+#include "Arduino.h"
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+    Adafruit_NeoPixel(uint16_t, int16_t, uint16_t) {}
+
+    void begin() {}
+    void setBrightness(uint8_t) {}
+    void setPixelColor(uint16_t, uint32_t color) { _color = color; }
+    void fill(uint32_t color, uint16_t, uint16_t) { _color = color; }
+    void show() {
+        Shown& last = lastShown();
+        last.color = _color;
+        last.at = std::chrono::steady_clock::now();
+        last.count++;
+    }
+
+    // Every strip's last show(), for checks
+    struct Shown {
+        uint32_t color = 0;
+        std::chrono::steady_clock::time_point at;
+        unsigned long count = 0;
+    };
+    static Shown& lastShown() {
+        static Shown shown;
+        return shown;
+    }
+
+private:
+    uint32_t _color = 0;
+};
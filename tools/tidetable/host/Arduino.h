@@ -0,0 +1,175 @@
+#pragma once
+// Just enough of the Arduino core to compile the firmware's storage and
+// parsing code on the host. Serial output is dropped unless a check captures
+// it; time comes from the host stand-ins in FirmwareHost.h.
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <utility>
+#include "HostHeap.h"
+
+#define RTC_DATA_ATTR
+#define PI 3.1415926535897932384626433832795
+
+using std::max;
+using std::min;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+long random(long howsmall, long howbig);
+
+// Like the ESP32 core's String: up to SSO_CAPACITY characters are kept in
+// the object, longer text in a heap buffer that every growth replaces. Heap
+// buffers go through HostHeap.
+class String {
+public:
+    static const size_t SSO_CAPACITY = 11;  // The core's on a 32-bit target
+
+    String() : _heap(nullptr), _length(0), _capacity(SSO_CAPACITY) { _sso[0] = '\0'; }
+    String(const char* text) : String() { assign(text, text ? strlen(text) : 0); }
+    String(const String& other) : String() { assign(other.c_str(), other._length); }
+    String(String&& other) : String() { swap(other); }
+    explicit String(long value) : String() { char text[24]; snprintf(text, sizeof(text), "%ld", value); *this = text; }
+    explicit String(double value, unsigned int decimals = 2) : String() {
+        char text[64];
+        snprintf(text, sizeof(text), "%.*f", (int)decimals, value);
+        *this = text;
+    }
+    ~String() { HostHeap::release(_heap); }
+
+    String& operator=(const String& other) {
+        if (this != &other) assign(other.c_str(), other._length);
+        return *this;
+    }
+    String& operator=(String&& other) {
+        swap(other);
+        return *this;
+    }
+    String& operator=(const char* text) { assign(text, text ? strlen(text) : 0); return *this; }
+
+    String& operator+=(const String& other) { return concat(other.c_str(), other._length); }
+    String& operator+=(const char* text) { return concat(text, text ? strlen(text) : 0); }
+    String& operator+=(char c) { return concat(&c, 1); }
+    String& operator+=(long value) { return *this += String(value); }
+    String& operator+=(double value) { return *this += String(value); }
+
+    bool reserve(size_t size) {
+        if (size <= _capacity) return true;
+        char* grown = (char*)HostHeap::allocate(size + 1);
+        if (grown == nullptr) return false;
+        memcpy(grown, buffer(), _length + 1);
+        HostHeap::release(_heap);
+        _heap = grown;
+        _capacity = size;
+        return true;
+    }
+
+    String substring(size_t from, size_t to) const {
+        String result;
+        if (from < to && to <= _length) result.assign(c_str() + from, to - from);
+        return result;
+    }
+    int indexOf(const char* text) const {
+        const char* found = strstr(c_str(), text);
+        return found ? (int)(found - c_str()) : -1;
+    }
+
+    friend String operator+(String left, const String& right) { return std::move(left += right); }
+    friend String operator+(String left, const char* right) { return std::move(left += right); }
+    friend String operator+(const char* left, const String& right) { return String(left) += right; }
+
+    const char* c_str() const { return _heap ? _heap : _sso; }
+    size_t length() const { return _length; }
+    bool operator==(const char* text) const { return strcmp(c_str(), text ? text : "") == 0; }
+    bool operator!=(const char* text) const { return !(*this == text); }
+    bool operator==(const String& other) const { return *this == other.c_str(); }
+    bool operator!=(const String& other) const { return !(*this == other.c_str()); }
+
+private:
+    char* buffer() { return _heap ? _heap : _sso; }
+
+    void swap(String& other) {
+        char sso[SSO_CAPACITY + 1];
+        memcpy(sso, _sso, sizeof(sso));
+        memcpy(_sso, other._sso, sizeof(sso));
+        memcpy(other._sso, sso, sizeof(sso));
+        std::swap(_heap, other._heap);
+        std::swap(_length, other._length);
+        std::swap(_capacity, other._capacity);
+    }
+    void assign(const char* text, size_t length) {
+        _length = 0;
+        concat(text, length);
+    }
+    String& concat(const char* text, size_t length) {
+        // Appending part of itself: find the text again after growing
+        const char* own = c_str();
+        bool inside = text >= own && text <= own + _length;
+        size_t offset = inside ? (size_t)(text - own) : 0;
+        if (!reserve(_length + length)) return *this;
+        if (inside) text = c_str() + offset;
+        if (length > 0) memmove(buffer() + _length, text, length);
+        _length += length;
+        buffer()[_length] = '\0';
+        return *this;
+    }
+
+    char* _heap;  // Null while the text fits in _sso
+    char _sso[SSO_CAPACITY + 1];
+    size_t _length;
+    size_t _capacity;
+};
+
+// Output is dropped unless a check captures it. There is no input.
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() {}
+    template <typename T> size_t print(const T&) { return 0; }
+    template <typename T> size_t println(const T&) { return 0; }
+    size_t println() { return 0; }
+    size_t println(const char* text) {
+        if (_capture != nullptr) {
+            HostHeap::Untracked untracked;
+            _capture->append(text).append("\n");
+        }
+        return 0;
+    }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        if (_capture != nullptr) {
+            char text[256];
+            va_list args;
+            va_start(args, format);
+            vsnprintf(text, sizeof(text), format, args);
+            va_end(args);
+            HostHeap::Untracked untracked;
+            _capture->append(text);
+        }
+        return 0;
+    }
+    explicit operator bool() const { return true; }
+
+    // Appends printf and println(const char*) output to out; nullptr drops it again
+    void capture(std::string* out) { _capture = out; }
+
+private:
+    std::string* _capture = nullptr;
+};
+
+extern HostSerial Serial;
+
+class HostEsp {
+public:
+    uint64_t getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+};
+
+extern HostEsp ESP;
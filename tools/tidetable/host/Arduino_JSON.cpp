@@ -0,0 +1,288 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include "Arduino_JSON.h"
+#include <climits>
+
+struct JsonNode {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<std::shared_ptr<const JsonNode>> children;  // Array elements or member values
+    std::vector<std::string> keys;                          // Member names, parallel to children
+};
+
+JSONClass JSON;
+
+namespace {
+
+const int NESTING_LIMIT = 1000;  // CJSON_NESTING_LIMIT
+
+typedef std::shared_ptr<JsonNode> NodePtr;
+
+class Parser {
+public:
+    explicit Parser(const char* text) : _p(text) {}
+
+    NodePtr parseDocument() {
+        skipWhitespace();
+        return parseValue(0);
+    }
+
+private:
+    void skipWhitespace() {
+        while (*_p != '\0' && (unsigned char)*_p <= 32) _p++;
+    }
+
+    bool consume(const char* literal) {
+        size_t length = strlen(literal);
+        if (strncmp(_p, literal, length) != 0) return false;
+        _p += length;
+        return true;
+    }
+
+    NodePtr parseValue(int depth) {
+        NodePtr node = std::make_shared<JsonNode>();
+        if (consume("null")) {
+            return node;
+        }
+        if (consume("false")) {
+            node->type = JsonNode::BOOLEAN;
+            return node;
+        }
+        if (consume("true")) {
+            node->type = JsonNode::BOOLEAN;
+            node->boolean = true;
+            return node;
+        }
+        if (*_p == '"') {
+            node->type = JsonNode::STRING;
+            return parseString(node->text) ? node : nullptr;
+        }
+        if (*_p == '-' || (*_p >= '0' && *_p <= '9')) {
+            node->type = JsonNode::NUMBER;
+            return parseNumber(node->number) ? node : nullptr;
+        }
+        if (*_p == '[' || *_p == '{') {
+            if (depth >= NESTING_LIMIT) return nullptr;
+            return *_p == '[' ? parseArray(node, depth + 1) : parseObject(node, depth + 1);
+        }
+        return nullptr;
+    }
+
+    bool parseNumber(double& number) {
+        char digits[64];
+        size_t length = 0;
+        while (length < sizeof(digits) - 1 && strchr("0123456789+-.eE", *_p) != nullptr && *_p != '\0') {
+            digits[length++] = *_p++;
+        }
+        digits[length] = '\0';
+        char* end = nullptr;
+        number = strtod(digits, &end);
+        if (end == digits) return false;
+        _p -= length - (size_t)(end - digits);  // Give back what strtod didn't use
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned long codepoint) {
+        if (codepoint < 0x80) {
+            out += (char)codepoint;
+        } else if (codepoint < 0x800) {
+            out += (char)(0xC0 | (codepoint >> 6));
+            out += (char)(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            out += (char)(0xE0 | (codepoint >> 12));
+            out += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            out += (char)(0x80 | (codepoint & 0x3F));
+        } else {
+            out += (char)(0xF0 | (codepoint >> 18));
+            out += (char)(0x80 | ((codepoint >> 12) & 0x3F));
+            out += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            out += (char)(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    bool parseHex4(unsigned long& value) {
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = *_p++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return false;
+        }
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        _p++;  // Opening quote
+        while (*_p != '"') {
+            if (*_p == '\0') return false;
+            if (*_p != '\\') {
+                out += *_p++;
+                continue;
+            }
+            _p++;
+            switch (*_p++) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case '"': case '\\': case '/': out += _p[-1]; break;
+                case 'u': {
+                    unsigned long codepoint;
+                    if (!parseHex4(codepoint) || (codepoint >= 0xDC00 && codepoint <= 0xDFFF)) return false;
+                    if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                        unsigned long low;
+                        if (_p[0] != '\\' || _p[1] != 'u') return false;
+                        _p += 2;
+                        if (!parseHex4(low) || low < 0xDC00 || low > 0xDFFF) return false;
+                        codepoint = 0x10000 + (((codepoint & 0x3FF) << 10) | (low & 0x3FF));
+                    }
+                    appendUtf8(out, codepoint);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        _p++;  // Closing quote
+        return true;
+    }
+
+    NodePtr parseArray(NodePtr node, int depth) {
+        node->type = JsonNode::ARRAY;
+        _p++;
+        skipWhitespace();
+        if (*_p == ']') {
+            _p++;
+            return node;
+        }
+        for (;;) {
+            skipWhitespace();
+            NodePtr child = parseValue(depth);
+            if (!child) return nullptr;
+            node->children.push_back(child);
+            skipWhitespace();
+            if (*_p == ',') {
+                _p++;
+            } else if (*_p == ']') {
+                _p++;
+                return node;
+            } else {
+                return nullptr;
+            }
+        }
+    }
+
+    NodePtr parseObject(NodePtr node, int depth) {
+        node->type = JsonNode::OBJECT;
+        _p++;
+        skipWhitespace();
+        if (*_p == '}') {
+            _p++;
+            return node;
+        }
+        for (;;) {
+            skipWhitespace();
+            std::string key;
+            if (*_p != '"' || !parseString(key)) return nullptr;
+            skipWhitespace();
+            if (*_p++ != ':') return nullptr;
+            skipWhitespace();
+            NodePtr child = parseValue(depth);
+            if (!child) return nullptr;
+            node->keys.push_back(key);
+            node->children.push_back(child);
+            skipWhitespace();
+            if (*_p == ',') {
+                _p++;
+            } else if (*_p == '}') {
+                _p++;
+                return node;
+            } else {
+                return nullptr;
+            }
+        }
+    }
+
+    const char* _p;
+};
+
+}
+
+JSONVar JSONClass::parse(const char* text) {
+    if (text == nullptr) return JSONVar();
+    HostHeap::Library library;  // cJSON's tree, not this one, is what the device allocates
+    return JSONVar(Parser(text).parseDocument());
+}
+
+String JSONClass::typeof_(const JSONVar& value) {
+    if (!value._node) return "undefined";
+    switch (value._node->type) {
+        case JsonNode::NUL: return "null";
+        case JsonNode::BOOLEAN: return "boolean";
+        case JsonNode::NUMBER: return "number";
+        case JsonNode::STRING: return "string";
+        case JsonNode::ARRAY: return "array";
+        case JsonNode::OBJECT: return "object";
+    }
+    return "unknown";
+}
+
+JSONVar JSONVar::operator[](const char* key) const {
+    if (_node && _node->type == JsonNode::OBJECT) {
+        // First match wins, as in cJSON_GetObjectItemCaseSensitive
+        for (size_t i = 0; i < _node->keys.size(); i++) {
+            if (_node->keys[i] == key) return JSONVar(_node->children[i]);
+        }
+    }
+    return JSONVar();
+}
+
+JSONVar JSONVar::operator[](int index) const {
+    if (_node && _node->type == JsonNode::ARRAY && index >= 0 && (size_t)index < _node->children.size()) {
+        return JSONVar(_node->children[index]);
+    }
+    return JSONVar();
+}
+
+bool JSONVar::hasOwnProperty(const char* key) const {
+    return JSON.typeof((*this)[key]) != "undefined";
+}
+
+int JSONVar::length() const {
+    if (_node && _node->type == JsonNode::STRING) return (int)_node->text.size();
+    if (_node && _node->type == JsonNode::ARRAY) return (int)_node->children.size();
+    return -1;
+}
+
+JSONVar::operator double() const {
+    return _node && _node->type == JsonNode::NUMBER ? _node->number : NAN;
+}
+
+JSONVar::operator int() const {
+    // cJSON saturates valueint
+    if (!_node || _node->type != JsonNode::NUMBER) return 0;
+    double number = _node->number;
+    if (number >= INT_MAX) return INT_MAX;
+    if (number <= (double)INT_MIN) return INT_MIN;
+    return (int)number;
+}
+
+JSONVar::operator bool() const {
+    return _node && _node->type == JsonNode::BOOLEAN && _node->boolean;
+}
+
+JSONVar::operator const char*() const {
+    return _node && _node->type == JsonNode::STRING ? _node->text.c_str() : nullptr;
+}
@@ -0,0 +1,46 @@
+#pragma once
+// Host stand-in for the Arduino_JSON library (JSONVar over cJSON), covering
+// the reads the firmware makes. Parsing follows cJSON: leading whitespace is
+// any byte up to space, bytes after the first value are ignored, a number
+// is whatever strtod takes from a run of [0-9+-.eE], and nesting deeper
+// than 1000 fails. Conversions follow JSONVar: a non-number reads as NaN, a
+// non-string as nullptr and anything but true as false. Lookups never change
+// the document; a missing member or element reads as undefined.
+#include <memory>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+struct JsonNode;
+
+class JSONVar {
+public:
+    JSONVar() {}
+
+    JSONVar operator[](const char* key) const;
+    JSONVar operator[](int index) const;
+    bool hasOwnProperty(const char* key) const;
+    int length() const;  // Array elements or string bytes, -1 for anything else
+
+    operator double() const;
+    operator int() const;
+    operator bool() const;
+    operator const char*() const;
+
+private:
+    friend class JSONClass;
+    explicit JSONVar(std::shared_ptr<const JsonNode> node) : _node(std::move(node)) {}
+
+    std::shared_ptr<const JsonNode> _node;  // Null for undefined
+};
+
+class JSONClass {
+public:
+    JSONVar parse(const char* text);
+    JSONVar parse(const String& text) { return parse(text.c_str()); }
+    String typeof_(const JSONVar& value);
+};
+
+#define typeof typeof_
+
+extern JSONClass JSON;
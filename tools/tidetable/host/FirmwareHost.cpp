@@ -0,0 +1,90 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include "FirmwareHost.h"
+#include <chrono>
+#include <random>
+#include "services/BootSequence.h"
+#include "services/EnergyMonitor.h"
+#include "services/TimeService.h"
+#include "storage/ConfigManager.h"
+
+HostSerial Serial;
+HostEsp ESP;
+
+namespace {
+
+time_t hostTime = 1735689600;
+const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+std::mt19937 randomSource(1);
+
+}
+
+void setHostTime(time_t now) {
+    hostTime = now;
+}
+
+unsigned long millis() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(unsigned long) {
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) return howsmall;
+    return howsmall + (long)(randomSource() % (unsigned long)(howbig - howsmall));
+}
+
+// Uptime from the host's clock, wall-clock time from setHostTime
+class HostClock : public Clock {
+public:
+    time_t now() override { return hostTime; }
+    unsigned long millis() override { return ::millis(); }
+    void sleep(unsigned long) override {}
+};
+
+HostClock hostClock;
+Clock* TimeService::clock = &hostClock;
+
+// The host clock reads setHostTime; a VirtualClock from setClock runs on its own
+time_t TimeService::getCurrentTime() {
+    return clock->now();
+}
+
+bool TimeService::isSynced() {
+    return true;
+}
+
+void TimeService::lightSleep(unsigned long ms) {
+    PowerPhaseScope phase(PowerPhase::LIGHT_SLEEP);
+    clock->lightSleep(ms);
+}
+
+// Only for debug output, which the host drops
+DurationString TimeService::formatSecondsToTime(unsigned long) {
+    return DurationString();
+}
+
+// ConfigManager.cpp holds the profile; the host changes it in place
+void setHostStation(const char* stationId) {
+    DeviceConfig& config = const_cast<DeviceConfig&>(ConfigManager::get());
+    snprintf(config.stationId, sizeof(config.stationId), "%s", stationId);
+}
+
+void BootSequence::markFirstPixel() {
+}
+
+// "config save" and "config reset" restart the device; on the host they return
+void BootSequence::restart() {
+}
@@ -0,0 +1,17 @@
+#pragma once
+// Host stand-ins for what the firmware's parsing and storage code calls but
+// only the device has: the clock and the device profile.
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+// What TimeService::getCurrentTime() returns
+void setHostTime(time_t now);
+
+// Changes the station of the device profile the firmware code sees
+void setHostStation(const char* stationId);
+
+// Public key the mbedtls stand-in checks signatures against in place of the
+// TIDE_TABLE_PUBLIC_KEY compiled in, which comes from whichever
+// wifi_credentials.h the build finds. Empty uses the compiled-in key.
+void setHostTablePublicKey(const std::vector<uint8_t>& key);
@@ -0,0 +1,158 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/param_build.h>
+#include <cstring>
+#include <vector>
+#include "FirmwareHost.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/md.h"
+
+namespace {
+
+const mbedtls_md_info_t SHA256_INFO = { MBEDTLS_MD_SHA256 };
+
+std::vector<uint8_t>& substituteKey() {
+    static std::vector<uint8_t> key;
+    return key;
+}
+
+EVP_PKEY* publicKey(const unsigned char* point, size_t length) {
+    OSSL_PARAM_BLD* builder = OSSL_PARAM_BLD_new();
+    OSSL_PARAM* params = nullptr;
+    EVP_PKEY_CTX* context = EVP_PKEY_CTX_new_from_name(nullptr, "EC", nullptr);
+    EVP_PKEY* key = nullptr;
+    if (builder != nullptr && context != nullptr &&
+        OSSL_PARAM_BLD_push_utf8_string(builder, OSSL_PKEY_PARAM_GROUP_NAME, "prime256v1", 0) == 1 &&
+        OSSL_PARAM_BLD_push_octet_string(builder, OSSL_PKEY_PARAM_PUB_KEY, point, length) == 1 &&
+        (params = OSSL_PARAM_BLD_to_param(builder)) != nullptr &&
+        EVP_PKEY_fromdata_init(context) == 1) {
+        EVP_PKEY_fromdata(context, &key, EVP_PKEY_PUBLIC_KEY, params);
+    }
+    OSSL_PARAM_free(params);
+    OSSL_PARAM_BLD_free(builder);
+    EVP_PKEY_CTX_free(context);
+    return key;
+}
+
+}
+
+void setHostTablePublicKey(const std::vector<uint8_t>& key) {
+    substituteKey() = key;
+}
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type) {
+    return type == MBEDTLS_MD_SHA256 ? &SHA256_INFO : nullptr;
+}
+
+void mbedtls_md_init(mbedtls_md_context_t* context) {
+    context->digest = nullptr;
+}
+
+int mbedtls_md_setup(mbedtls_md_context_t* context, const mbedtls_md_info_t* info, int hmac) {
+    if (info == nullptr || hmac != 0) return -1;
+    context->digest = EVP_MD_CTX_new();
+    return context->digest != nullptr ? 0 : -1;
+}
+
+int mbedtls_md_starts(mbedtls_md_context_t* context) {
+    return context->digest != nullptr &&
+           EVP_DigestInit_ex((EVP_MD_CTX*)context->digest, EVP_sha256(), nullptr) == 1 ? 0 : -1;
+}
+
+int mbedtls_md_update(mbedtls_md_context_t* context, const unsigned char* input, size_t length) {
+    return context->digest != nullptr &&
+           EVP_DigestUpdate((EVP_MD_CTX*)context->digest, input, length) == 1 ? 0 : -1;
+}
+
+int mbedtls_md_finish(mbedtls_md_context_t* context, unsigned char* output) {
+    return context->digest != nullptr &&
+           EVP_DigestFinal_ex((EVP_MD_CTX*)context->digest, output, nullptr) == 1 ? 0 : -1;
+}
+
+void mbedtls_md_free(mbedtls_md_context_t* context) {
+    EVP_MD_CTX_free((EVP_MD_CTX*)context->digest);
+    context->digest = nullptr;
+}
+
+int mbedtls_md(const mbedtls_md_info_t* info, const unsigned char* input, size_t length, unsigned char* output) {
+    return info != nullptr && EVP_Digest(input, length, output, nullptr, EVP_sha256(), nullptr) == 1 ? 0 : -1;
+}
+
+void mbedtls_ecp_group_init(mbedtls_ecp_group* group) {
+    group->id = MBEDTLS_ECP_DP_NONE;
+}
+
+int mbedtls_ecp_group_load(mbedtls_ecp_group* group, mbedtls_ecp_group_id id) {
+    group->id = id;
+    return id == MBEDTLS_ECP_DP_SECP256R1 ? 0 : -1;
+}
+
+void mbedtls_ecp_group_free(mbedtls_ecp_group*) {
+}
+
+void mbedtls_ecp_point_init(mbedtls_ecp_point* point) {
+    point->length = 0;
+}
+
+int mbedtls_ecp_point_read_binary(const mbedtls_ecp_group*, mbedtls_ecp_point* point,
+                                  const unsigned char* buffer, size_t length) {
+    if (!substituteKey().empty()) {
+        buffer = substituteKey().data();
+        length = substituteKey().size();
+    }
+    if (length != sizeof(point->bytes) || buffer[0] != 0x04) return -1;
+    memcpy(point->bytes, buffer, length);
+    point->length = length;
+    return 0;
+}
+
+void mbedtls_ecp_point_free(mbedtls_ecp_point*) {
+}
+
+void mbedtls_mpi_init(mbedtls_mpi* value) {
+    memset(value->bytes, 0, sizeof(value->bytes));
+}
+
+int mbedtls_mpi_read_binary(mbedtls_mpi* value, const unsigned char* buffer, size_t length) {
+    if (length > sizeof(value->bytes)) return -1;
+    memset(value->bytes, 0, sizeof(value->bytes));
+    memcpy(value->bytes + sizeof(value->bytes) - length, buffer, length);
+    return 0;
+}
+
+void mbedtls_mpi_free(mbedtls_mpi*) {
+}
+
+int mbedtls_ecdsa_verify(mbedtls_ecp_group* group, const unsigned char* digest, size_t digestLength,
+                         const mbedtls_ecp_point* key, const mbedtls_mpi* r, const mbedtls_mpi* s) {
+    if (group->id != MBEDTLS_ECP_DP_SECP256R1 || key->length == 0) return -1;
+    EVP_PKEY* verifier = publicKey(key->bytes, key->length);
+    ECDSA_SIG* signature = ECDSA_SIG_new();
+    BIGNUM* rValue = BN_bin2bn(r->bytes, sizeof(r->bytes), nullptr);
+    BIGNUM* sValue = BN_bin2bn(s->bytes, sizeof(s->bytes), nullptr);
+    unsigned char* der = nullptr;
+    int derLength = 0;
+    if (signature != nullptr && rValue != nullptr && sValue != nullptr && ECDSA_SIG_set0(signature, rValue, sValue) == 1) {
+        rValue = sValue = nullptr;  // Owned by signature now
+        derLength = i2d_ECDSA_SIG(signature, &der);
+    }
+    EVP_PKEY_CTX* context = verifier != nullptr ? EVP_PKEY_CTX_new(verifier, nullptr) : nullptr;
+    bool valid = derLength > 0 && context != nullptr && EVP_PKEY_verify_init(context) == 1 &&
+                 EVP_PKEY_verify(context, der, (size_t)derLength, digest, digestLength) == 1;
+    EVP_PKEY_CTX_free(context);
+    OPENSSL_free(der);
+    BN_free(rValue);
+    BN_free(sValue);
+    ECDSA_SIG_free(signature);
+    EVP_PKEY_free(verifier);
+    return valid ? 0 : -1;
+}
@@ -0,0 +1,198 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include "HostHeap.h"
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace {
+
+// Prefixed to every real allocation, so release() knows where the block sits
+// in the model without a lookup table of its own
+struct alignas(16) Prefix {
+    uint32_t offset;
+    uint32_t size;
+    uint32_t run;  // Which model it was placed in; 0 if none
+};
+
+const uint32_t NOT_PLACED = UINT32_MAX;
+const size_t MODEL_ALIGN = 8;
+const size_t MODEL_HEADER = 8;  // Per-block overhead, about what ESP-IDF's heap adds
+
+struct FreeBlock {
+    uint32_t offset;
+    uint32_t size;
+};
+
+// Free blocks in address order, adjacent ones always merged
+std::vector<FreeBlock>* freeBlocks = nullptr;
+HostHeap::Stats current = {};
+size_t arenaBytes = 0;
+uint32_t run = 0;
+bool running = false;
+int untrackedDepth = 0;
+int libraryDepth = 0;
+bool modelling = false;  // The model's own vector is being resized
+
+uint32_t place(size_t size) {
+    size_t needed = (size + MODEL_ALIGN - 1) / MODEL_ALIGN * MODEL_ALIGN + MODEL_HEADER;
+    for (size_t i = 0; i < freeBlocks->size(); i++) {
+        FreeBlock& block = (*freeBlocks)[i];
+        if (block.size < needed) continue;
+        uint32_t offset = block.offset;
+        block.offset += (uint32_t)needed;
+        block.size -= (uint32_t)needed;
+        if (block.size == 0) {
+            freeBlocks->erase(freeBlocks->begin() + i);
+        }
+        current.used += needed;
+        if (current.used > current.peak) current.peak = current.used;
+        return offset;
+    }
+    current.failures++;
+    return NOT_PLACED;
+}
+
+void unplace(uint32_t offset, size_t size) {
+    uint32_t needed = (uint32_t)((size + MODEL_ALIGN - 1) / MODEL_ALIGN * MODEL_ALIGN + MODEL_HEADER);
+    current.used -= needed;
+    std::vector<FreeBlock>& blocks = *freeBlocks;
+    size_t low = 0, high = blocks.size();
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (blocks[middle].offset < offset) low = middle + 1;
+        else high = middle;
+    }
+    size_t i = low;
+    bool joinsPrevious = i > 0 && blocks[i - 1].offset + blocks[i - 1].size == offset;
+    bool joinsNext = i < blocks.size() && offset + needed == blocks[i].offset;
+    if (joinsPrevious && joinsNext) {
+        blocks[i - 1].size += needed + blocks[i].size;
+        blocks.erase(blocks.begin() + i);
+    } else if (joinsPrevious) {
+        blocks[i - 1].size += needed;
+    } else if (joinsNext) {
+        blocks[i].offset = offset;
+        blocks[i].size += needed;
+    } else {
+        blocks.insert(blocks.begin() + i, FreeBlock{ offset, needed });
+    }
+}
+
+}
+
+void HostHeap::start(size_t bytes) {
+    modelling = true;
+    if (freeBlocks == nullptr) {
+        freeBlocks = new std::vector<FreeBlock>();
+        freeBlocks->reserve(1024);
+    }
+    freeBlocks->assign(1, FreeBlock{ 0, (uint32_t)bytes });
+    modelling = false;
+    current = Stats();
+    arenaBytes = bytes;
+    run++;
+    running = true;
+}
+
+void HostHeap::stop() {
+    running = false;
+}
+
+HostHeap::Stats HostHeap::stats() {
+    Stats stats = current;
+    stats.free = arenaBytes - current.used;
+    stats.largestFree = 0;
+    for (const FreeBlock& block : *freeBlocks) {
+        if (block.size > stats.largestFree) stats.largestFree = block.size;
+    }
+    return stats;
+}
+
+void* HostHeap::allocate(size_t size) {
+    Prefix* prefix = (Prefix*)malloc(sizeof(Prefix) + size);
+    if (prefix == nullptr) {
+        return nullptr;
+    }
+    prefix->size = (uint32_t)size;
+    prefix->offset = NOT_PLACED;
+    prefix->run = 0;
+    if (running && untrackedDepth == 0 && !modelling) {
+        modelling = true;
+        current.allocations++;
+        if (libraryDepth > 0) current.libraryAllocations++;
+        prefix->offset = place(size);
+        prefix->run = prefix->offset == NOT_PLACED ? 0 : run;
+        modelling = false;
+    }
+    return prefix + 1;
+}
+
+void HostHeap::release(void* pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    Prefix* prefix = (Prefix*)pointer - 1;
+    if (running && prefix->run == run) {
+        modelling = true;
+        unplace(prefix->offset, prefix->size);
+        modelling = false;
+    }
+    free(prefix);
+}
+
+HostHeap::Untracked::Untracked() {
+    untrackedDepth++;
+}
+
+HostHeap::Untracked::~Untracked() {
+    untrackedDepth--;
+}
+
+HostHeap::Library::Library() {
+    libraryDepth++;
+}
+
+HostHeap::Library::~Library() {
+    libraryDepth--;
+}
+
+void* operator new(size_t size) {
+    void* pointer = HostHeap::allocate(size);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return HostHeap::allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return HostHeap::allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    HostHeap::release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    HostHeap::release(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    HostHeap::release(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    HostHeap::release(pointer);
+}
@@ -0,0 +1,51 @@
+#pragma once
+// Replays the host's heap traffic on a model of a small first-fit heap, so a
+// long run shows the peak use and fragmentation the same allocations would
+// leave on the device. While a model is running every operator new and every
+// String buffer is placed in it as well as really allocated. Block sizes are
+// the host's, so pointer-heavy structures come out larger than on the ESP32.
+#include <cstddef>
+
+class HostHeap {
+public:
+    struct Stats {
+        size_t used;                // Including each block's header
+        size_t peak;
+        size_t free;
+        size_t largestFree;
+        unsigned long allocations;
+        unsigned long libraryAllocations;  // Of those, made inside a Library scope
+        unsigned long failures;     // Requests the model had no room for
+
+        // As main.cpp reports it on the device
+        unsigned fragmentation() const { return free > 0 ? 100 - (unsigned)(largestFree * 100 / free) : 0; }
+    };
+
+    static void start(size_t bytes);
+    static void stop();
+    static Stats stats();
+
+    static void* allocate(size_t size);
+    static void release(void* pointer);
+
+    // Allocations made while one of these is alive are not modelled, for
+    // host stand-ins whose storage lives outside the heap on the device
+    class Untracked {
+    public:
+        Untracked();
+        ~Untracked();
+        Untracked(const Untracked&) = delete;
+        Untracked& operator=(const Untracked&) = delete;
+    };
+
+    // Allocations made while one of these is alive are modelled but counted
+    // apart, for host stand-ins of libraries whose own allocations differ on
+    // the device
+    class Library {
+    public:
+        Library();
+        ~Library();
+        Library(const Library&) = delete;
+        Library& operator=(const Library&) = delete;
+    };
+};
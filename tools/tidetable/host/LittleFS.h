@@ -0,0 +1,94 @@
+#pragma once
+// In-memory stand-in for the ESP32 LittleFS library. Open files see each
+// other's writes, and rename replaces an existing file in one step, as
+// LittleFS does. The store is flash on the device, so it stays out of
+// HostHeap.
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+
+class File {
+public:
+    File() {}
+    explicit File(std::shared_ptr<std::vector<uint8_t>> data, bool writable) : _data(data), _writable(writable) {}
+
+    explicit operator bool() const { return _data != nullptr; }
+    size_t size() const { return _data ? _data->size() : 0; }
+    bool seek(size_t position) {
+        if (!_data || position > _data->size()) return false;
+        _position = position;
+        return true;
+    }
+    size_t read(uint8_t* buffer, size_t length) {
+        if (!_data || _position >= _data->size()) return 0;
+        length = std::min(length, _data->size() - _position);
+        memcpy(buffer, _data->data() + _position, length);
+        _position += length;
+        return length;
+    }
+    size_t write(const uint8_t* buffer, size_t length) {
+        if (!_data || !_writable) return 0;
+        HostHeap::Untracked untracked;
+        if (_data->size() < _position + length) _data->resize(_position + length);
+        memcpy(_data->data() + _position, buffer, length);
+        _position += length;
+        return length;
+    }
+    void close() {
+        HostHeap::Untracked untracked;
+        _data.reset();
+    }
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> _data;
+    size_t _position = 0;
+    bool _writable = false;
+};
+
+class HostLittleFS {
+public:
+    bool begin(bool = false) { return true; }
+    bool exists(const char* path) { return files().count(path) > 0; }
+    File open(const char* path, const char* mode) {
+        HostHeap::Untracked untracked;
+        if (strcmp(mode, FILE_WRITE) == 0) {
+            files()[path] = std::make_shared<std::vector<uint8_t>>();
+        }
+        auto found = files().find(path);
+        return found == files().end() ? File() : File(found->second, strcmp(mode, FILE_WRITE) == 0);
+    }
+    bool remove(const char* path) {
+        HostHeap::Untracked untracked;
+        return files().erase(path) > 0;
+    }
+    bool rename(const char* from, const char* to) {
+        HostHeap::Untracked untracked;
+        auto found = files().find(from);
+        if (found == files().end()) return false;
+        std::shared_ptr<std::vector<uint8_t>> data = found->second;
+        files().erase(found);
+        files()[to] = data;
+        return true;
+    }
+    // Empties the file system, for checks
+    void format() {
+        HostHeap::Untracked untracked;
+        files().clear();
+    }
+
+private:
+    static std::map<std::string, std::shared_ptr<std::vector<uint8_t>>>& files() {
+        static auto* instance = [] {
+            HostHeap::Untracked untracked;
+            return new std::map<std::string, std::shared_ptr<std::vector<uint8_t>>>();
+        }();
+        return *instance;
+    }
+};
+
+inline HostLittleFS LittleFS;
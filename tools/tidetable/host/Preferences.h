@@ -0,0 +1,86 @@
+#pragma once
+// In-memory stand-in for the ESP32 Preferences library. Namespaces are
+// shared by every instance, like NVS, and strings keep NVS's 4000 byte limit.
+// The store is flash on the device, so it stays out of HostHeap.
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+class Preferences {
+public:
+    static const size_t MAX_STRING = 4000;  // Including the terminator
+
+    bool begin(const char* name, bool = false) {
+        HostHeap::Untracked untracked;
+        _namespace = &store()[name];
+        return true;
+    }
+    void end() { _namespace = nullptr; }
+    bool clear() {
+        if (_namespace == nullptr) return false;
+        HostHeap::Untracked untracked;
+        _namespace->clear();
+        return true;
+    }
+    bool remove(const char* key) {
+        HostHeap::Untracked untracked;
+        return _namespace != nullptr && _namespace->erase(key) > 0;
+    }
+
+    size_t putString(const char* key, const char* value) {
+        size_t length = strlen(value);
+        if (_namespace == nullptr || length + 1 > MAX_STRING) return 0;
+        HostHeap::Untracked untracked;
+        (*_namespace)[key].assign(value, value + length + 1);
+        return length;
+    }
+    // Like nvs_get_str: 0 if missing or if it doesn't fit in maxLen, else the length with terminator
+    size_t getString(const char* key, char* value, size_t maxLen) {
+        const std::vector<char>* stored = find(key);
+        if (stored == nullptr || stored->size() > maxLen) return 0;
+        memcpy(value, stored->data(), stored->size());
+        return stored->size();
+    }
+    // The Arduino form, which copies onto the heap
+    String getString(const char* key, const String& defaultValue = String()) {
+        const std::vector<char>* stored = find(key);
+        return stored == nullptr ? defaultValue : String(stored->data());
+    }
+
+    size_t putBytes(const char* key, const void* value, size_t length) {
+        if (_namespace == nullptr) return 0;
+        HostHeap::Untracked untracked;
+        (*_namespace)[key].assign((const char*)value, (const char*)value + length);
+        return length;
+    }
+    size_t getBytes(const char* key, void* buffer, size_t maxLen) {
+        const std::vector<char>* stored = find(key);
+        if (stored == nullptr || stored->size() > maxLen) return 0;
+        memcpy(buffer, stored->data(), stored->size());
+        return stored->size();
+    }
+
+    // Every namespace, for tests that start from empty flash
+    static void eraseAll() {
+        HostHeap::Untracked untracked;
+        for (std::map<std::string, Namespace>::iterator it = store().begin(); it != store().end(); ++it) {
+            it->second.clear();
+        }
+    }
+
+private:
+    typedef std::map<std::string, std::vector<char>> Namespace;
+
+    static std::map<std::string, Namespace>& store() {
+        static std::map<std::string, Namespace> namespaces;
+        return namespaces;
+    }
+    const std::vector<char>* find(const char* key) const {
+        if (_namespace == nullptr) return nullptr;
+        Namespace::const_iterator it = _namespace->find(key);
+        return it == _namespace->end() ? nullptr : &it->second;
+    }
+
+    Namespace* _namespace = nullptr;
+};
@@ -0,0 +1,126 @@
+#pragma once
+// Stand-in for PubSubClient backed by an in-process broker with one
+// persistent session, enough to drive PushService the way a real broker
+// does:
+// - a retained message is sent to every new subscription, including each
+//   resubscribe after a reconnect
+// - messages for subscribed topics are queued while the client is away
+// - loop() hands each message to the callback from the client's one buffer,
+//   which the next message overwrites, and drops messages that don't fit
+#include <deque>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "WiFi.h"
+
+class PubSubClient {
+public:
+    typedef std::function<void(char*, uint8_t*, unsigned int)> Callback;
+
+    explicit PubSubClient(WiFiClient&) {}
+
+    PubSubClient& setServer(const char*, uint16_t) { return *this; }
+    PubSubClient& setCallback(Callback callback) {
+        _callback = callback;
+        return *this;
+    }
+    PubSubClient& setKeepAlive(uint16_t) { return *this; }
+    PubSubClient& setSocketTimeout(uint16_t) { return *this; }
+    bool setBufferSize(uint16_t size) {
+        HostHeap::Untracked untracked;
+        _buffer.assign(size, 0);
+        return true;
+    }
+
+    bool connect(const char*, const char*, const char*, const char*, uint8_t, bool, const char*, bool cleanSession) {
+        Broker& session = broker();
+        if (!session.reachable) {
+            _state = -2;  // MQTT_CONNECT_FAILED
+            return false;
+        }
+        if (cleanSession) {
+            session.subscriptions.clear();
+            session.queued.clear();
+        }
+        session.connected = true;
+        _state = 0;
+        return true;
+    }
+    bool connected() { return broker().connected; }
+    int state() { return _state; }
+
+    bool subscribe(const char* topic, uint8_t) {
+        Broker& session = broker();
+        if (!session.connected) return false;
+        HostHeap::Untracked untracked;
+        session.subscriptions.insert(topic);
+        auto retained = session.retained.find(topic);
+        if (retained != session.retained.end()) {
+            session.queued.push_back({ topic, retained->second });
+        }
+        return true;
+    }
+
+    bool loop() {
+        Broker& session = broker();
+        while (session.connected && !session.queued.empty()) {
+            Message message;
+            {
+                HostHeap::Untracked untracked;
+                message = session.queued.front();
+                session.queued.pop_front();
+            }
+            // Topic, payload and fixed header as the real client lays them out
+            size_t needed = message.topic.size() + 1 + message.payload.size() + 5;
+            if (needed > _buffer.size() || !_callback) continue;
+            memcpy(_buffer.data(), message.topic.c_str(), message.topic.size() + 1);
+            uint8_t* payload = _buffer.data() + message.topic.size() + 1;
+            memcpy(payload, message.payload.data(), message.payload.size());
+            _callback((char*)_buffer.data(), payload, (unsigned int)message.payload.size());
+        }
+        return session.connected;
+    }
+
+    // The broker's side, for checks. An empty retained payload clears the
+    // topic's retained message, as in MQTT.
+    static void publish(const char* topic, const std::vector<uint8_t>& payload, bool retain) {
+        Broker& session = broker();
+        HostHeap::Untracked untracked;
+        if (retain) {
+            if (payload.empty()) {
+                session.retained.erase(topic);
+            } else {
+                session.retained[topic] = payload;
+            }
+        }
+        if (!payload.empty() && session.subscriptions.count(topic)) {
+            session.queued.push_back({ topic, payload });
+        }
+    }
+    static void dropConnection() { broker().connected = false; }
+    static void setReachable(bool reachable) { broker().reachable = reachable; }
+    static size_t pending() { return broker().queued.size(); }
+
+private:
+    struct Message {
+        std::string topic;
+        std::vector<uint8_t> payload;
+    };
+    struct Broker {
+        std::map<std::string, std::vector<uint8_t>> retained;
+        std::set<std::string> subscriptions;  // The persistent session's
+        std::deque<Message> queued;           // For the session, delivered by loop()
+        bool connected = false;
+        bool reachable = true;
+    };
+    static Broker& broker() {
+        static Broker* instance = [] { HostHeap::Untracked untracked; return new Broker(); }();
+        return *instance;
+    }
+
+    Callback _callback;
+    std::vector<uint8_t> _buffer;
+    int _state = -1;  // MQTT_DISCONNECTED
+};
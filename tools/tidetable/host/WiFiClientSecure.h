@@ -0,0 +1,8 @@
+#pragma once
+// Stand-in for the ESP32's TLS client; see WiFi.h
+#include "WiFi.h"
+
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setInsecure() {}
+};
@@ -0,0 +1,15 @@
+#pragma once
+// Host build's wifi_credentials.h, found only when src/config has none. The
+// checks don't rely on this key: the mbedtls stand-in verifies against the
+// key a check signs with (setHostTablePublicKey).
+#include <cstdint>
+
+const char* const WIFI_SSID = "host";
+const char* const WIFI_PASSWORD = "";
+const char* const TIDE_API_ENDPOINT = "https://api.flowebb.com/graphql";
+const char* const TIDE_TABLE_URL = "https://api.flowebb.com/tables/";
+const uint8_t TIDE_TABLE_PUBLIC_KEY[65] = { 0x04 };
+const char* const MQTT_BROKER_HOST = "localhost";
+const uint16_t MQTT_BROKER_PORT = 1883;
+const char* const MQTT_USERNAME = "";
+const char* const MQTT_PASSWORD = "";
@@ -0,0 +1,10 @@
+#pragma once
+// The host can't light-sleep, so SystemClock::lightSleep falls back to delay()
+#include <cstdint>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+inline esp_err_t esp_sleep_enable_timer_wakeup(uint64_t) { return ESP_FAIL; }
+inline esp_err_t esp_light_sleep_start() { return ESP_FAIL; }
@@ -0,0 +1,33 @@
+#pragma once
+// Stand-in for mbedtls' ECDSA verification, P-256 only, on OpenSSL. A check
+// can substitute its own public key for the one the firmware passes; see
+// setHostTablePublicKey in FirmwareHost.h.
+#include <cstddef>
+
+typedef enum { MBEDTLS_ECP_DP_NONE = 0, MBEDTLS_ECP_DP_SECP256R1 = 3 } mbedtls_ecp_group_id;
+
+typedef struct mbedtls_ecp_group {
+    mbedtls_ecp_group_id id;
+} mbedtls_ecp_group;
+
+typedef struct mbedtls_ecp_point {
+    unsigned char bytes[65];  // Uncompressed
+    size_t length;
+} mbedtls_ecp_point;
+
+typedef struct mbedtls_mpi {
+    unsigned char bytes[32];  // Big-endian, right-aligned
+} mbedtls_mpi;
+
+void mbedtls_ecp_group_init(mbedtls_ecp_group* group);
+int mbedtls_ecp_group_load(mbedtls_ecp_group* group, mbedtls_ecp_group_id id);
+void mbedtls_ecp_group_free(mbedtls_ecp_group* group);
+void mbedtls_ecp_point_init(mbedtls_ecp_point* point);
+int mbedtls_ecp_point_read_binary(const mbedtls_ecp_group* group, mbedtls_ecp_point* point,
+                                  const unsigned char* buffer, size_t length);
+void mbedtls_ecp_point_free(mbedtls_ecp_point* point);
+void mbedtls_mpi_init(mbedtls_mpi* value);
+int mbedtls_mpi_read_binary(mbedtls_mpi* value, const unsigned char* buffer, size_t length);
+void mbedtls_mpi_free(mbedtls_mpi* value);
+int mbedtls_ecdsa_verify(mbedtls_ecp_group* group, const unsigned char* digest, size_t digestLength,
+                         const mbedtls_ecp_point* key, const mbedtls_mpi* r, const mbedtls_mpi* s);
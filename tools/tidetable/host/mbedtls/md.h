@@ -0,0 +1,22 @@
+#pragma once
+// Stand-in for mbedtls' message digests, SHA-256 only, on OpenSSL
+#include <cstddef>
+
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA256 = 6 } mbedtls_md_type_t;
+
+typedef struct mbedtls_md_info_t {
+    mbedtls_md_type_t type;
+} mbedtls_md_info_t;
+
+typedef struct mbedtls_md_context_t {
+    void* digest;  // OpenSSL EVP_MD_CTX
+} mbedtls_md_context_t;
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type);
+void mbedtls_md_init(mbedtls_md_context_t* context);
+int mbedtls_md_setup(mbedtls_md_context_t* context, const mbedtls_md_info_t* info, int hmac);
+int mbedtls_md_starts(mbedtls_md_context_t* context);
+int mbedtls_md_update(mbedtls_md_context_t* context, const unsigned char* input, size_t length);
+int mbedtls_md_finish(mbedtls_md_context_t* context, unsigned char* output);
+void mbedtls_md_free(mbedtls_md_context_t* context);
+int mbedtls_md(const mbedtls_md_info_t* info, const unsigned char* input, size_t length, unsigned char* output);
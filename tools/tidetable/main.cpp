@@ -0,0 +1,433 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "Options.h"
+#include "TableFile.h"
+#include "WorkStealingPool.h"
+#include "models/TideBlend.h"
+#include "models/TideTimeline.h"
+
+namespace {
+
+void usage() {
+    fprintf(stderr,
+        "usage: tidetable <command> [options]\n"
+        "  keygen --output KEY.pem\n"
+        "        new signing key, unless KEY.pem exists; prints its public half for wifi_credentials.h\n"
+        "  build --station ID --key KEY.pem --input extremes.csv --output ID.tbl [--revision N]\n"
+        "        CSV lines are epoch_seconds,height_meters,H|L in time order\n"
+        "  patch --key KEY.pem --from old.tbl --to new.tbl --output ID.<old revision>.patch\n"
+        "  level --station ID --key KEY.pem --height METERS --output ID.level [--time EPOCH] [--sequence N]\n"
+        "        signed observed-level reading for push mode; the sequence defaults to the time\n"
+        "  dump  --key KEY.pem --input ID.tbl\n"
+        "  batch --key KEY.pem --input DIR --output DIR [--revision N] [--threads N]\n"
+        "        [--bench 1,2,4,... [--repeat N]]\n"
+        "        builds DIR/<station>.tbl for every <station>.csv, in parallel\n"
+        "  blend --predicted extremes.csv --observed levels.csv [--every SECONDS]\n"
+        "        levels.csv lines are epoch_seconds,height_meters in time order\n");
+}
+
+TableContents loadTable(const std::string& path, const SigningKey& key) {
+    std::vector<uint8_t> bytes;
+    if (!readFile(path, bytes)) {
+        throw std::runtime_error("cannot read " + path);
+    }
+    TableContents table;
+    std::string error;
+    if (!decodeSignedTable(bytes, key, table, error)) {
+        throw std::runtime_error(path + ": " + error);
+    }
+    return table;
+}
+
+// Keeps an existing key, so running it again only prints the public half
+int keygen(const Options& options) {
+    std::string path = require(options, "output");
+    if (!std::filesystem::exists(path)) {
+        if (!SigningKey::generate().save(path)) {
+            throw std::runtime_error("failed to write " + path);
+        }
+        fprintf(stderr, "wrote %s; keep it off devices and out of the repository\n", path.c_str());
+    }
+    std::vector<uint8_t> publicKey = SigningKey::load(path).publicKey();
+    if (publicKey.size() != TIDE_TABLE_PUBLIC_KEY_SIZE) {
+        throw std::runtime_error("unexpected public key size");
+    }
+    printf("const uint8_t TIDE_TABLE_PUBLIC_KEY[] = {");
+    for (size_t i = 0; i < publicKey.size(); i++) {
+        printf("%s0x%02x,", i % 12 == 0 ? "\n    " : " ", publicKey[i]);
+    }
+    printf("\n};\n");
+    return 0;
+}
+
+int build(const Options& options) {
+    TableContents table;
+    std::string error;
+    if (!readExtremesCsv(require(options, "input"), table, error)) {
+        throw std::runtime_error(error);
+    }
+    if (!TideTableCodec::setStationId(table.info.stationId, require(options, "station").c_str())) {
+        throw std::runtime_error("station id too long");
+    }
+    table.info.revision = (uint32_t)std::stoul(optional(options, "revision", "1"));
+
+    std::vector<uint8_t> bytes;
+    if (!encodeSignedTable(table, SigningKey::load(require(options, "key")), bytes) || !writeFile(require(options, "output"), bytes)) {
+        throw std::runtime_error("failed to write table");
+    }
+    printf("%u extremes -> %zu bytes (%.2f bytes per extreme)\n",
+        table.info.count, bytes.size(), table.info.count ? (double)bytes.size() / table.info.count : 0.0);
+    return 0;
+}
+
+int patch(const Options& options) {
+    SigningKey key = SigningKey::load(require(options, "key"));
+    TableContents from = loadTable(require(options, "from"), key);
+    TableContents to = loadTable(require(options, "to"), key);
+    if (!TideTableCodec::sameStation(from.info.stationId, to.info.stationId) || from.info.baseTime != to.info.baseTime) {
+        throw std::runtime_error("tables must share station and base time");
+    }
+    if (to.info.revision <= from.info.revision || to.info.count < from.info.count) {
+        throw std::runtime_error("new table must have a higher revision and no fewer extremes");
+    }
+
+    std::vector<TideTablePatchEntry> entries;
+    for (uint32_t i = 0; i < to.info.count; i++) {
+        const TideTableRecord& record = to.records[i];
+        if (i < from.info.count && memcmp(&record, &from.records[i], sizeof(record)) == 0) {
+            continue;
+        }
+        TideTablePatchEntry entry;
+        entry.index = i;
+        entry.record = record;
+        entries.push_back(entry);
+    }
+    if (entries.size() > TIDE_TABLE_MAX_PATCH_ENTRIES) {
+        throw std::runtime_error("too many changes for one patch, ship a new table instead");
+    }
+
+    TideTablePatchInfo info;
+    memcpy(info.stationId, to.info.stationId, sizeof(info.stationId));
+    info.fromRevision = from.info.revision;
+    info.toRevision = to.info.revision;
+    info.count = (uint16_t)entries.size();
+    VectorSink sink;
+    TideTableCodec::encodePatch(info, entries.data(), sink);
+    appendSignature(sink.bytes, key);
+    if (!writeFile(require(options, "output"), sink.bytes)) {
+        throw std::runtime_error("failed to write patch");
+    }
+    printf("revision %u -> %u: %zu changed extremes, %zu bytes\n",
+        info.fromRevision, info.toRevision, entries.size(), sink.bytes.size());
+    return 0;
+}
+
+int level(const Options& options) {
+    TideLevelReading reading;
+    if (!TideTableCodec::setStationId(reading.stationId, require(options, "station").c_str())) {
+        throw std::runtime_error("station id too long");
+    }
+    double height = std::stod(require(options, "height"));
+    if (height < -300 || height > 300) {
+        throw std::runtime_error("height out of range");
+    }
+    reading.heightCm = (int16_t)(height * 100 + (height < 0 ? -0.5 : 0.5));
+    reading.timestamp = std::stoll(optional(options, "time", std::to_string(time(nullptr)).c_str()));
+    // Devices drop a reading whose sequence isn't above the last one they took
+    reading.sequence = (uint32_t)std::stoul(optional(options, "sequence", std::to_string(reading.timestamp).c_str()));
+
+    VectorSink sink;
+    TideTableCodec::encodeLevel(reading, sink);
+    appendSignature(sink.bytes, SigningKey::load(require(options, "key")));
+    if (!writeFile(require(options, "output"), sink.bytes)) {
+        throw std::runtime_error("failed to write level reading");
+    }
+    printf("%s: %.2f m at %lld, sequence %u: %zu bytes\n", reading.stationId, reading.heightCm / 100.0,
+        (long long)reading.timestamp, reading.sequence, sink.bytes.size());
+    return 0;
+}
+
+int dump(const Options& options) {
+    TableContents table = loadTable(require(options, "input"), SigningKey::load(require(options, "key")));
+    printf("# station %s, revision %u, %u extremes\n", table.info.stationId, table.info.revision, table.info.count);
+    for (size_t i = 0; i < table.records.size(); i++) {
+        const TideTableRecord& record = table.records[i];
+        printf("%lld,%.2f,%c\n", (long long)(table.info.baseTime + record.offset),
+            record.heightCm / 100.0, record.isHigh ? 'H' : 'L');
+    }
+    return 0;
+}
+
+struct StationJob {
+    std::string station;
+    std::string input;
+    std::string output;
+    std::vector<uint8_t> bytes;  // Signed table, empty on error
+    uint32_t count = 0;
+    std::string error;
+};
+
+// Same steps as build, for one station of a batch. Errors are recorded
+// rather than thrown, so one bad file doesn't stop the rest of the fleet.
+void buildStation(StationJob& job, const SigningKey& key, uint32_t revision) {
+    job.bytes.clear();
+    job.error.clear();
+    TableContents table;
+    std::string error;
+    try {
+        if (!readExtremesCsv(job.input, table, error)) {
+            job.error = error;
+            return;
+        }
+    } catch (const std::exception&) {
+        job.error = job.input + ": malformed number";
+        return;
+    }
+    if (!TideTableCodec::setStationId(table.info.stationId, job.station.c_str())) {
+        job.error = "station id too long";
+        return;
+    }
+    table.info.revision = revision;
+    if (!encodeSignedTable(table, key, job.bytes) || !writeFile(job.output, job.bytes)) {
+        job.bytes.clear();
+        job.error = "failed to write " + job.output;
+        return;
+    }
+    job.count = table.info.count;
+}
+
+std::vector<unsigned> parseThreadCounts(const std::string& list) {
+    std::vector<unsigned> counts;
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        counts.push_back((unsigned)std::stoul(list.substr(start, end - start)));
+        start = end + 1;
+    }
+    return counts;
+}
+
+// Builds tables for a whole fleet. Every station is independent, the
+// stations are sorted by id and signatures are deterministic, so the tables
+// and the report are byte for byte the same whatever the thread count.
+// --bench runs the batch --repeat times at each thread count and reports
+// stations per second. It fails if any table, or any file written, differs
+// from the first run's.
+int batch(const Options& options) {
+    namespace fs = std::filesystem;
+    SigningKey key = SigningKey::load(require(options, "key"));
+    fs::path inputDir = require(options, "input");
+    fs::path outputDir = require(options, "output");
+    uint32_t revision = (uint32_t)std::stoul(optional(options, "revision", "1"));
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts = parseThreadCounts(
+        optional(options, "bench", optional(options, "threads", std::to_string(hardware).c_str()).c_str()));
+    int repeat = options.count("bench") ? std::stoi(optional(options, "repeat", "2")) : 1;
+
+    std::vector<StationJob> jobs;
+    for (const fs::directory_entry& entry : fs::directory_iterator(inputDir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".csv") {
+            StationJob job;
+            job.station = entry.path().stem().string();
+            job.input = entry.path().string();
+            job.output = (outputDir / (job.station + ".tbl")).string();
+            jobs.push_back(job);
+        }
+    }
+    std::sort(jobs.begin(), jobs.end(),
+        [](const StationJob& a, const StationJob& b) { return a.station < b.station; });
+    if (jobs.empty()) {
+        throw std::runtime_error("no .csv files in " + inputDir.string());
+    }
+    fs::create_directories(outputDir);
+
+    std::vector<std::vector<uint8_t>> firstRun;
+    for (unsigned threads : threadCounts) {
+        for (int run = 0; run < repeat; run++) {
+            WorkStealingPool pool(threads);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            pool.run(jobs.size(), [&](size_t i) { buildStation(jobs[i], key, revision); });
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (firstRun.empty()) {
+                for (const StationJob& job : jobs) {
+                    firstRun.push_back(job.bytes);
+                }
+            }
+            for (size_t i = 0; i < jobs.size(); i++) {
+                std::vector<uint8_t> written;
+                if (jobs[i].bytes != firstRun[i]) {
+                    throw std::runtime_error(jobs[i].station + ": table differs between runs");
+                }
+                if (!jobs[i].bytes.empty() && (!readFile(jobs[i].output, written) || written != firstRun[i])) {
+                    throw std::runtime_error(jobs[i].output + ": file differs from the table built");
+                }
+            }
+            if (options.count("bench")) {
+                printf("%2u threads, run %d: %zu stations in %.3f s, %.0f stations/s, %zu steals\n",
+                    pool.threads(), run + 1, jobs.size(), seconds, jobs.size() / seconds, pool.steals());
+            }
+        }
+    }
+
+    int failed = 0;
+    uint64_t extremes = 0, bytes = 0;
+    for (const StationJob& job : jobs) {
+        if (!job.error.empty()) {
+            fprintf(stderr, "%s: %s\n", job.station.c_str(), job.error.c_str());
+            failed++;
+        }
+        extremes += job.count;
+        bytes += job.bytes.size();
+    }
+    printf("%zu stations, %d failed: %llu extremes -> %llu bytes in %s\n",
+        jobs.size(), failed, (unsigned long long)extremes, (unsigned long long)bytes, outputDir.string().c_str());
+    return failed ? 1 : 0;
+}
+
+double rms(double sumSquares, long count) {
+    return count ? std::sqrt(sumSquares / count) : 0.0;
+}
+
+// Replays an observed series against predicted extremes through the
+// firmware's TideBlend, as the device would see it: each reading is scored
+// before it is folded in, and only one every --every seconds is folded in, to
+// match how often observations arrive. Reports height and next-extreme time
+// errors of the prediction alone and of the blend, and the cost of estimate(),
+// which runs every frame.
+int blend(const Options& options) {
+    TableContents table;
+    std::vector<ObservedLevel> levels;
+    std::string error;
+    if (!readExtremesCsv(require(options, "predicted"), table, error) ||
+        !readLevelsCsv(require(options, "observed"), levels, error)) {
+        throw std::runtime_error(error);
+    }
+    long every = std::stol(optional(options, "every", "3600"));
+
+    std::vector<TideExtreme> extremes = tableExtremes(table);
+    if (extremes.size() < 2 || levels.empty()) {
+        throw std::runtime_error("need at least two extremes and one reading");
+    }
+
+    // Where each extreme actually happened: the highest or lowest reading
+    // within a quarter cycle of the prediction
+    std::vector<int64_t> observedTimes(extremes.size(), 0);
+    for (size_t i = 0; i < extremes.size(); i++) {
+        int64_t window = 3 * 3600;
+        const ObservedLevel* best = nullptr;
+        for (const ObservedLevel& level : levels) {
+            if (std::llabs(level.timestamp - (int64_t)extremes[i].timestamp) > window) continue;
+            if (best == nullptr || (extremes[i].isHigh ? level.height > best->height : level.height < best->height)) {
+                best = &level;
+            }
+        }
+        if (best != nullptr) {
+            observedTimes[i] = best->timestamp;
+        }
+    }
+
+    TideBlendState state;
+    TideBlend::reset(state);
+    std::vector<time_t> lastForecast(extremes.size(), 0);  // Corrected time, as of the last reading before it
+    double predictedSquares = 0, blendedSquares = 0;
+    long scored = 0, folded = 0;
+    int64_t lastFolded = 0;
+    for (const ObservedLevel& level : levels) {
+        time_t now = (time_t)level.timestamp;
+        size_t next = extremeAfter(extremes, now);
+        if (next == 0 || next == extremes.size()) continue;
+        const TideExtreme& previous = extremes[next - 1];
+
+        TideEstimate estimate = TideBlend::estimate(state, previous, extremes[next], now);
+        if (state.observations > 0) {
+            predictedSquares += (estimate.predicted - level.height) * (estimate.predicted - level.height);
+            blendedSquares += (estimate.height - level.height) * (estimate.height - level.height);
+            scored++;
+            lastForecast[next] = estimate.nextExtreme;
+        }
+        if ((folded == 0 || level.timestamp - lastFolded >= every) &&
+            TideBlend::observe(state, previous, extremes[next], now, level.height)) {
+            lastFolded = level.timestamp;
+            folded++;
+        }
+    }
+
+    double predictedTimeSquares = 0, blendedTimeSquares = 0;
+    long timed = 0;
+    for (size_t i = 0; i < extremes.size(); i++) {
+        if (lastForecast[i] == 0 || observedTimes[i] == 0) continue;
+        double predictedMiss = (double)(extremes[i].timestamp - observedTimes[i]);
+        double blendedMiss = (double)(lastForecast[i] - observedTimes[i]);
+        predictedTimeSquares += predictedMiss * predictedMiss;
+        blendedTimeSquares += blendedMiss * blendedMiss;
+        timed++;
+    }
+
+    // Per-frame cost, over the same spread of times and states as the replay
+    const long TICKS = 2000000;
+    double checksum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long i = 0; i < TICKS; i++) {
+        const TideExtreme& previous = extremes[i % (extremes.size() - 1)];
+        const TideExtreme& next = extremes[i % (extremes.size() - 1) + 1];
+        time_t now = previous.timestamp + (i % 997) * (next.timestamp - previous.timestamp) / 997;
+        checksum += TideBlend::estimate(state, previous, next, now).height;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double predictedRms = rms(predictedSquares, scored), blendedRms = rms(blendedSquares, scored);
+    printf("%zu readings, %ld scored, %ld folded in (one per %ld s)\n", levels.size(), scored, folded, every);
+    printf("height RMS error: predicted %.3f m, blended %.3f m (%+.0f%%)\n",
+        predictedRms, blendedRms, predictedRms > 0 ? 100.0 * (blendedRms / predictedRms - 1.0) : 0.0);
+    if (timed > 0) {
+        double predictedTimeRms = rms(predictedTimeSquares, timed), blendedTimeRms = rms(blendedTimeSquares, timed);
+        printf("next extreme RMS error over %ld extremes: predicted %.0f s, blended %.0f s (%+.0f%%)\n",
+            timed, predictedTimeRms, blendedTimeRms,
+            predictedTimeRms > 0 ? 100.0 * (blendedTimeRms / predictedTimeRms - 1.0) : 0.0);
+    }
+    printf("estimate(): %.1f ns per frame on this host (checksum %.1f)\n", seconds * 1e9 / TICKS, checksum);
+    return 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (argc < 2 || !parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    std::string command = argv[1];
+    try {
+        if (command == "keygen") return keygen(options);
+        if (command == "build") return build(options);
+        if (command == "patch") return patch(options);
+        if (command == "level") return level(options);
+        if (command == "dump") return dump(options);
+        if (command == "batch") return batch(options);
+        if (command == "blend") return blend(options);
+    } catch (const std::exception& e) {
+        fprintf(stderr, "tidetable: %s\n", e.what());
+        return 1;
+    }
+    usage();
+    return 2;
+}
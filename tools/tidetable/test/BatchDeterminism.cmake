@@ -0,0 +1,58 @@
+# Runs `tidetable batch --bench` twice, in separate processes, over the same
+# stations and key, and fails unless every table comes out byte for byte the
+# same. Within a run --bench already compares thread counts and repeats.
+#
+#   cmake -DTIDETABLE=<path> -DWORK_DIR=<dir> -P BatchDeterminism.cmake
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/stations")
+
+# Twenty stations of 400 alternating extremes each, a little different per station
+foreach(station RANGE 8447500 8447519)
+    math(EXPR time "1735689600 + (${station} - 8447500) * 611")
+    set(lines "")
+    foreach(i RANGE 399)
+        math(EXPR high "${i} % 2")
+        math(EXPR centimeters "(${i} * 37 + ${station}) % 90 + (${high} * 180)")
+        math(EXPR meters "${centimeters} / 100")
+        math(EXPR fraction "${centimeters} % 100")
+        if(fraction LESS 10)
+            set(fraction "0${fraction}")
+        endif()
+        if(high)
+            set(type H)
+        else()
+            set(type L)
+        endif()
+        string(APPEND lines "${time},${meters}.${fraction},${type}\n")
+        math(EXPR time "${time} + 22357 + (${i} % 7) * 60")
+    endforeach()
+    file(WRITE "${WORK_DIR}/stations/${station}.csv" "${lines}")
+endforeach()
+
+function(run_tidetable)
+    execute_process(COMMAND "${TIDETABLE}" ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "tidetable ${ARGN} failed:\n${output}")
+    endif()
+    message(STATUS "${output}")
+endfunction()
+
+run_tidetable(keygen --output "${WORK_DIR}/key.pem")
+foreach(run first second)
+    run_tidetable(batch --key "${WORK_DIR}/key.pem" --input "${WORK_DIR}/stations" --output "${WORK_DIR}/${run}"
+        --bench 1,2,4 --repeat 2)
+endforeach()
+
+file(GLOB tables RELATIVE "${WORK_DIR}/first" "${WORK_DIR}/first/*.tbl")
+list(LENGTH tables count)
+if(NOT count EQUAL 20)
+    message(FATAL_ERROR "expected 20 tables, got ${count}")
+endif()
+foreach(table ${tables})
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/first/${table}" "${WORK_DIR}/second/${table}"
+        RESULT_VARIABLE different)
+    if(different)
+        message(FATAL_ERROR "${table} differs between runs")
+    endif()
+endforeach()
@@ -0,0 +1,84 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include "EnergyChecks.h"
+#include "FirmwareChecks.h"
+#include "Options.h"
+#include "PushChecks.h"
+#include "TableChecks.h"
+
+// Property tests, fuzzers and benchmarks of the firmware's code on the host.
+// ctest runs each with small counts; run them by hand for longer.
+namespace {
+
+void usage() {
+    fprintf(stderr,
+        "usage: firmware-checks <check> [options]\n"
+        "  bench [--input ID.tbl --key KEY.pem] [--iterations N]\n"
+        "        table decoder throughput\n"
+        "  fuzz-table [--input ID.tbl --key KEY.pem] [--iterations N] [--seed N]\n"
+        "        mutated tables and patches through the firmware's decoders\n"
+        "  signing [--iterations N] [--seed N]\n"
+        "        RFC 6979 test vectors and reproducibility of table signatures\n"
+        "  timeline [--lookups N]\n"
+        "        lookup cost of the firmware's extreme timeline at 20 to 10,000 entries\n"
+        "  frames [--predicted extremes.csv] [--observed levels.csv] [--start EPOCH] [--hours N]\n"
+        "         [--update SECONDS] [--outage SECONDS]\n"
+        "        checks queued LED frames against frame-at-a-time rendering\n"
+        "  drift [--ppm N] [--wander N] [--noise-ms N] [--resync SECONDS] [--tolerance SECONDS] [--days N]\n"
+        "        simulated NTP syncs through the firmware's RTC drift estimator\n"
+        "  fuzz-json [--iterations N] [--seed N]\n"
+        "        mutated saved state and API responses through the firmware's JSON parsing\n"
+        "  fuzz-validator [--iterations N] [--seed N]\n"
+        "        mutated extreme sets through the firmware's validator\n"
+        "  soak [--cycles N] [--renders N] [--heap-kb N] [--background N] [--seed N]\n"
+        "        heap use and fragmentation of fetch/save/render cycles, before and after FixedString\n"
+        "  props [--iterations N] [--seed N]\n"
+        "        save/restore round trips, and generated API responses against their model\n"
+        "  config [--iterations N]\n"
+        "        device profile load time against the tide data restore, and config show\n"
+        "  energy [--days N] [--fetch api|table] [--render sleep|poll] [--<profile field> VALUE ...]\n"
+        "         [--associate-ms N] [--tls-ms N] [--http-ms N] [--parse-ms N] [--save-ms N] [--load-ms N]\n"
+        "        the firmware's energy model over simulated days, with a device profile saved to NVS\n"
+        "  push\n"
+        "        retained, duplicate and out-of-order MQTT messages through PushService to the LED\n");
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (argc < 2 || !parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    std::string check = argv[1];
+    try {
+        if (check == "bench") return bench(options);
+        if (check == "fuzz-table") return fuzzTable(options);
+        if (check == "signing") return signing(options);
+        if (check == "timeline") return timelineBench(options);
+        if (check == "frames") return frames(options);
+        if (check == "drift") return drift(options);
+        if (check == "fuzz-json") return fuzzJson(options);
+        if (check == "fuzz-validator") return fuzzValidator(options);
+        if (check == "soak") return soak(options);
+        if (check == "props") return properties(options);
+        if (check == "config") return configLoad(options);
+        if (check == "energy") return energy(options);
+        if (check == "push") return push(options);
+    } catch (const std::exception& e) {
+        fprintf(stderr, "firmware-checks: %s\n", e.what());
+        return 1;
+    }
+    usage();
+    return 2;
+}
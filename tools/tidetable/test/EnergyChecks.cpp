@@ -0,0 +1,198 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include "EnergyChecks.h"
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+#include "TableChecks.h"
+#include "display/LedController.h"
+#include "services/Clock.h"
+#include "services/EnergyMonitor.h"
+#include "services/TimeService.h"
+#include "storage/ConfigManager.h"
+#include "storage/TideTableStore.h"
+
+namespace {
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        throw std::runtime_error("energy: " + what);
+    }
+}
+
+// Awake time per refresh that the host can't measure, and its default in ms
+struct ModelledPhase {
+    const char* option;
+    PowerPhase phase;
+    const char* fallback;
+};
+
+const ModelledPhase API_FETCH[] = {
+    {"associate-ms", PowerPhase::WIFI_ASSOCIATE, "2500"},
+    {"tls-ms", PowerPhase::TLS, "900"},
+    {"http-ms", PowerPhase::HTTP, "700"},
+    {"parse-ms", PowerPhase::PARSE, "40"},
+    {"save-ms", PowerPhase::NVS_SAVE, "30"},
+};
+const ModelledPhase TABLE_LOAD[] = {
+    {"load-ms", PowerPhase::NVS_LOAD, "15"},
+};
+
+bool isField(const std::string& name) {
+    for (int i = 0; i < DeviceConfig::fieldCount(); i++) {
+        if (name == DeviceConfig::fieldName(i)) return true;
+    }
+    return false;
+}
+
+bool isModelled(const std::string& name) {
+    for (const ModelledPhase& cost : API_FETCH) {
+        if (name == cost.option) return true;
+    }
+    return name == TABLE_LOAD[0].option;
+}
+
+// Saves the profile options from the console and loads it back from NVS.
+// A value can be refused until another is in, e.g. wave_min_ms above the
+// current wave_max_ms, so refused ones are retried while any go in.
+void loadProfile(const Options& options) {
+    Preferences::eraseAll();
+    ConfigManager::initialize();
+    std::vector<std::string> waiting;
+    for (Options::const_iterator it = options.begin(); it != options.end(); ++it) {
+        if (isField(it->first)) {
+            waiting.push_back(it->first);
+        } else {
+            check(it->first == "days" || it->first == "render" || it->first == "fetch" || isModelled(it->first),
+                "unknown option --" + it->first);
+        }
+    }
+    for (size_t before = waiting.size() + 1; !waiting.empty() && waiting.size() < before; ) {
+        before = waiting.size();
+        std::vector<std::string> refused;
+        for (const std::string& name : waiting) {
+            std::string command = "config set " + name + " " + options.at(name);
+            std::string output;
+            Serial.capture(&output);
+            ConfigManager::handleCommand(command.c_str());
+            Serial.capture(nullptr);
+            if (output.find("Invalid") != std::string::npos) {
+                refused.push_back(name);
+            }
+        }
+        waiting.swap(refused);
+    }
+    if (!waiting.empty()) {
+        check(false, "--" + waiting.front() + " " + options.at(waiting.front()) + " rejected");
+    }
+    ConfigManager::handleCommand("config save");
+    ConfigManager::initialize();
+
+    std::string shown;
+    Serial.capture(&shown);
+    ConfigManager::handleCommand("config show");
+    Serial.capture(nullptr);
+    check(shown.find("Not saved") == std::string::npos, "the profile loaded from NVS differs from the one saved");
+}
+
+void runPhases(VirtualClock& clock, const ModelledPhase* costs, size_t count, const Options& options) {
+    for (size_t i = 0; i < count; i++) {
+        PowerPhaseScope phase(costs[i].phase);
+        clock.advance(std::stoul(optional(options, costs[i].option, costs[i].fallback)));
+    }
+}
+
+float highestPhaseCurrent() {
+    const float currents[] = {
+        CURRENT_BOOT_MA, CURRENT_IDLE_MA, CURRENT_NVS_MA, CURRENT_WIFI_ASSOCIATE_MA,
+        CURRENT_TLS_MA, CURRENT_HTTP_MA, CURRENT_PARSE_MA, CURRENT_LIGHT_SLEEP_MA,
+    };
+    return *std::max_element(currents, currents + sizeof(currents) / sizeof(currents[0]));
+}
+
+}
+
+int energy(const Options& options) {
+    long days = std::stol(optional(options, "days", "3"));
+    std::string fetch = optional(options, "fetch", "api");
+    check(days > 0, "--days must be positive");
+    check(fetch == "api" || fetch == "table", "--fetch must be api or table");
+    loadProfile(options);
+    const DeviceConfig& config = ConfigManager::get();
+    std::string render = optional(options, "render", config.pushMode ? "poll" : "sleep");
+    check(render == "sleep" || render == "poll", "--render must be sleep or poll");
+
+    // The tides to show, as a provisioned table for the profile's station
+    TableContents table = syntheticTable((int)days + 14);
+    TideTableCodec::setStationId(table.info.stationId, config.stationId);
+    LittleFS.format();
+    check(TideTableStore::beginTable(table.info), "beginTable failed");
+    for (const TideTableRecord& record : table.records) {
+        check(TideTableStore::appendRecord(record), "appendRecord failed");
+    }
+    check(TideTableStore::commitTable(), "commitTable failed");
+
+    // From the first local midnight a day into the table, so each report is a whole day
+    const long DAY = 86400;
+    long offset = config.utcOffsetSec();
+    time_t start = ((table.info.baseTime + DAY + offset) / DAY + 1) * DAY - offset;
+    VirtualClock clock(start, 0);
+    TimeService::setClock(&clock);
+    EnergyMonitor::beginWake();
+    LedController::initialize();
+    EnergyMonitor::enterPhase(PowerPhase::IDLE);
+
+    TideData data;
+    long refreshes = 0;
+    double totalMah = 0;
+    for (long day = 0; day < days; day++) {
+        // The report is taken in the day's last second, before the ledger rolls over
+        time_t dayEnd = start + (day + 1) * DAY - 1;
+        while (clock.now() < dayEnd) {
+            time_t now = clock.now();
+            if (data.needsUpdate(now)) {
+                if (fetch == "api") {
+                    runPhases(clock, API_FETCH, sizeof(API_FETCH) / sizeof(API_FETCH[0]), options);
+                } else {
+                    runPhases(clock, TABLE_LOAD, 1, options);
+                }
+                check(TideTableStore::loadWindow(data, clock.now()), "no tide window at " + std::to_string(now));
+                refreshes++;
+            }
+            // As loop() does: queued frames from light sleep, or a frame per pass
+            if (render == "sleep") {
+                LedController::playFrames(data, std::min(data.getNextUpdateTime(), dayEnd));
+            } else {
+                LedController::updateDisplay(data);
+            }
+            clock.sleep(10);
+        }
+
+        std::string report;
+        Serial.capture(&report);
+        EnergyMonitor::printReport();
+        Serial.capture(nullptr);
+        printf("day %ld:\n%s", day + 1, report.c_str());
+        totalMah += EnergyMonitor::todayMah();
+        clock.advance(1000);
+    }
+
+    double averageMa = totalMah / days / 24.0;
+    printf("%ld refreshes (%s), %s rendering, brightness %u: %.2f mAh per day, avg %.2f mA, "
+           "%.1f days on %.0f mAh\n",
+        refreshes, fetch.c_str(), render.c_str(), (unsigned)config.brightness, totalMah / days, averageMa,
+        BATTERY_CAPACITY_MAH / (averageMa * 24.0), BATTERY_CAPACITY_MAH);
+
+    float ledMaxMa = CURRENT_LED_CHANNEL_MA * 3 * config.brightness / 255.0f * NUM_LEDS;
+    check(averageMa >= CURRENT_LIGHT_SLEEP_MA && averageMa <= highestPhaseCurrent() + ledMaxMa,
+        "average current outside what the coefficients allow");
+    return 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "Options.h"
+
+// Runs the firmware's EnergyMonitor over --days simulated days on a
+// VirtualClock, to compare duty-cycle settings before they reach devices.
+// The device profile is saved and loaded through ConfigManager as on the
+// device: any DeviceConfig field given as an option (--brightness 32,
+// --wave_min_ms 60000, --update_sec 21600, ...) goes through "config set"
+// and "config save" first. LedController renders a synthetic table's tides
+// with that profile, playing queued frames from light sleep, or polling when
+// --render poll or push mode is set.
+//
+// Awake time the host can't measure is modelled: each refresh due under
+// update_sec costs --associate-ms, --tls-ms, --http-ms, --parse-ms and
+// --save-ms in their PowerPhases with --fetch api, or --load-ms of NVS_LOAD
+// with --fetch table. Prints the firmware's energy report for each day and
+// the average; fails if the average current is outside what the current
+// coefficients allow.
+int energy(const Options& options);
@@ -0,0 +1,882 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include "FirmwareChecks.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "FirmwareHost.h"
+#include "HostHeap.h"
+#include "display/FrameRenderer.h"
+#include "models/DeviceConfig.h"
+#include "models/TideValidator.h"
+#include "services/TimeService.h"
+#include "storage/ConfigManager.h"
+#include "storage/PreferencesManager.h"
+#include "utils/JsonHelper.h"
+#include "utils/TideResponseParser.h"
+
+namespace {
+
+const time_t NOW = 1760000000;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        throw std::runtime_error(what);
+    }
+}
+
+double uniform(std::mt19937& rng, double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(rng);
+}
+
+int randomCentimeters(std::mt19937& rng) {
+    const TideValidationLimits& limits = DEFAULT_VALIDATION_LIMITS;
+    return (int)std::lround(uniform(rng, limits.minHeight, limits.maxHeight) * 100);
+}
+
+// Well-formed tide data at the resolution the firmware keeps it
+TideData randomTideData(std::mt19937& rng) {
+    TideData data;
+    data.type = (TideType)(rng() % 5);
+    data.currentHeight = (float)uniform(rng, -5, 20);
+    data.lastUpdateTime = (unsigned long)rng();
+    time_t time = (time_t)(1600000000 + rng() % 400000000);
+    data.current.timestamp = time;
+    data.current.height = randomCentimeters(rng) / 100.0f;
+    data.current.isHigh = rng() & 1;
+    int count = (int)(rng() % (TideTimeline::CAPACITY + 1));
+    for (int i = 0; i < count; i++) {
+        time += 1 + rng() % 60000;
+        data.extremes.push(time, randomCentimeters(rng) / 100.0f, rng() & 1);
+    }
+    return data;
+}
+
+std::string serialize(const TideData& data) {
+    TideJsonBuffer json;
+    check(JsonHelper::serializeTideData(data, json), "tide data did not fit the JSON buffer");
+    return json.c_str();
+}
+
+bool sameExtreme(const TideExtreme& a, const TideExtreme& b) {
+    return a.timestamp == b.timestamp && a.height == b.height && a.isHigh == b.isHigh;
+}
+
+void checkFinite(const TideData& data, const char* path) {
+    check(std::isfinite(data.currentHeight) && std::isfinite(data.current.height),
+        std::string(path) + " accepted a height that is not finite");
+    for (int i = 0; i < data.extremes.size(); i++) {
+        check(std::isfinite(data.extremes.height(i)), std::string(path) + " accepted an extreme that is not finite");
+    }
+}
+
+// What TideResponseParser promises about anything it accepts
+void checkPublished(const TideData& data, time_t now) {
+    const TideValidationLimits& limits = DEFAULT_VALIDATION_LIMITS;
+    checkFinite(data, "response");
+    check(data.current.timestamp <= now, "current extreme is in the future");
+    for (int i = 0; i < data.extremes.size(); i++) {
+        check(data.extremes.timestamp(i) > now, "published extreme is not in the future");
+        check(data.extremes.height(i) >= limits.minHeight - 0.005f && data.extremes.height(i) <= limits.maxHeight + 0.005f,
+            "published extreme outside the height limits");
+        if (i > 0) {
+            long spacing = (long)(data.extremes.timestamp(i) - data.extremes.timestamp(i - 1));
+            check(spacing >= limits.minSpacingSec && spacing <= limits.maxSpacingSec, "published extremes badly spaced");
+            check(data.extremes.isHigh(i) != data.extremes.isHigh(i - 1), "published extremes do not alternate");
+        }
+    }
+}
+
+struct ModelExtreme {
+    int64_t timestampMs;
+    double height;
+    bool isHigh;
+};
+
+// A tide API response as data, to generate text from and check the parse against
+struct ResponseModel {
+    std::vector<ModelExtreme> extremes;
+    std::string tideType;
+    bool hasLevel;
+    double level;
+};
+
+double millimeters(double meters) {
+    return std::round(meters * 1000) / 1000;
+}
+
+ResponseModel randomResponse(std::mt19937& rng, time_t now) {
+    static const char* const TYPES[] = { "RISING", "FALLING", "HIGH", "LOW", "SLACK" };
+    ResponseModel model;
+    model.tideType = TYPES[rng() % 5];
+    model.hasLevel = rng() % 4 != 0;
+    model.level = millimeters(uniform(rng, -1, 4));
+
+    bool isHigh = rng() & 1;
+    for (time_t time = now - 18 * 3600 - (time_t)(rng() % (12 * 3600)); time < now + 6 * 86400;
+         time += 5 * 3600 + (time_t)(rng() % 9000)) {
+        ModelExtreme extreme;
+        extreme.timestampMs = (int64_t)time * 1000 + rng() % 1000;
+        extreme.height = millimeters(isHigh ? uniform(rng, 1, 4) : uniform(rng, -1, 0.5));
+        extreme.isHigh = isHigh;
+        model.extremes.push_back(extreme);
+        isHigh = !isHigh;
+    }
+    return model;
+}
+
+// The model as the API might send it: members in any order, any whitespace,
+// fields the firmware ignores
+std::string renderResponse(const ResponseModel& model, std::mt19937& rng) {
+    static const char* const SPACES[] = { "", " ", "\n  ", "\t", "\r\n" };
+    auto space = [&]() { return std::string(SPACES[rng() % 5]); };
+    auto object = [&](std::vector<std::string> members) {
+        std::shuffle(members.begin(), members.end(), rng);
+        std::string text = "{" + space();
+        for (size_t i = 0; i < members.size(); i++) {
+            text += (i ? "," + space() : "") + members[i];
+        }
+        return text + space() + "}";
+    };
+    char number[64];
+
+    std::vector<std::string> extremes;
+    for (const ModelExtreme& extreme : model.extremes) {
+        std::vector<std::string> members;
+        snprintf(number, sizeof(number), "%lld", (long long)extreme.timestampMs);
+        members.push_back("\"timestamp\":" + space() + number);
+        snprintf(number, sizeof(number), "%.3f", extreme.height);
+        members.push_back("\"height\"" + space() + ":" + number);
+        members.push_back(std::string("\"type\":\"") + (extreme.isHigh ? "HIGH" : "LOW") + "\"");
+        extremes.push_back(object(members));
+    }
+    std::string array = "[" + space();
+    for (size_t i = 0; i < extremes.size(); i++) {
+        array += (i ? "," + space() : "") + extremes[i];
+    }
+    array += "]";
+
+    std::vector<std::string> tides;
+    tides.push_back("\"localTime\":\"2025-10-09T12:00:00\"");
+    tides.push_back("\"timeZoneOffsetSeconds\":-14400");
+    tides.push_back("\"tideType\":\"" + model.tideType + "\"");
+    snprintf(number, sizeof(number), "%.3f", model.level);
+    tides.push_back(std::string("\"waterLevel\":") + (model.hasLevel ? number : "null"));
+    tides.push_back("\"extremes\":" + space() + array);
+    return object({ "\"data\":" + object({ "\"tides\":" + object(tides) }) });
+}
+
+// The parse must match the model exactly: the last extreme at or before now
+// is current, the later ones fill the timeline in order at centimeter
+// resolution, and the water level is taken as is
+void checkAgainstModel(const TideData& data, const ResponseModel& model, time_t now) {
+    std::vector<TideExtreme> expected;
+    TideExtreme current = {};
+    for (const ModelExtreme& extreme : model.extremes) {
+        TideExtreme converted = { (time_t)(extreme.timestampMs / 1000), (float)extreme.height, extreme.isHigh };
+        if (converted.timestamp <= now) {
+            current = converted;
+        } else if ((int)expected.size() < TideTimeline::CAPACITY) {
+            converted.height = std::round(converted.height * 100.0f) / 100.0f;
+            expected.push_back(converted);
+        }
+    }
+    check(sameExtreme(data.current, current), "current extreme differs from the model");
+    check(data.extremes.size() == (int)expected.size(), "number of future extremes differs from the model");
+    for (size_t i = 0; i < expected.size(); i++) {
+        check(sameExtreme(data.extremes.at((int)i), expected[i]), "extreme " + std::to_string(i) + " differs from the model");
+    }
+    check(data.type == parseTideType(model.tideType.c_str()), "tide type differs from the model");
+    check(data.currentHeight == (model.hasLevel ? (float)model.level : 0.0f), "water level differs from the model");
+    check(data.lastUpdateTime == (unsigned long)now, "update time is not the parse time");
+}
+
+void mutate(std::string& text, std::mt19937& rng) {
+    static const char* const TOKENS[] = {
+        "{", "}", "[", "]", "\"", ",", ":", " ", "null", "true", "false", "0", "-0", "-1", "1e999", "-1e999",
+        "4e12", "1e-400", "NaN", "99999999999999999999999999", "\"timestamp\"", "\"height\"", "\"extremes\"",
+        "\"isHigh\"", "\"type\"", "\"HIGH\"", "\"data\"", "\"tides\"", "\\u0000", "\\ud800", "\\uDC00", "\\",
+        "\xff", "\x00",
+    };
+    const size_t TOKEN_COUNT = sizeof(TOKENS) / sizeof(TOKENS[0]);
+    int operations = 1 + rng() % 4;
+    for (int i = 0; i < operations; i++) {
+        size_t position = text.empty() ? 0 : rng() % (text.size() + 1);
+        switch (rng() % 7) {
+            case 0:
+                if (!text.empty()) text[rng() % text.size()] ^= (char)(1u << (rng() % 8));
+                break;
+            case 1:
+                text.erase(position, 1 + rng() % 16);
+                break;
+            case 2: {
+                const char* token = TOKENS[rng() % TOKEN_COUNT];
+                text.insert(position, token, token[0] == '\0' ? 1 : strlen(token));
+                break;
+            }
+            case 3:
+                if (!text.empty()) {
+                    size_t from = rng() % text.size();
+                    text.insert(position, text.substr(from, 1 + rng() % 64));
+                }
+                break;
+            case 4:
+                text.resize(position);
+                break;
+            case 5:
+                if (!text.empty()) text[rng() % text.size()] = "0123456789-.eE"[rng() % 14];
+                break;
+            default:
+                text.insert(position, std::string(1 + rng() % 1200, "[{"[rng() % 2]));
+                break;
+        }
+    }
+}
+
+// A plausible response's extremes, then a few of the mistakes a server or
+// a corrupted payload could make
+TideCandidates randomCandidates(std::mt19937& rng, time_t now) {
+    TideCandidates candidates;
+    candidates.clear();
+    ResponseModel model = randomResponse(rng, now);
+    for (const ModelExtreme& extreme : model.extremes) {
+        candidates.add((time_t)(extreme.timestampMs / 1000), (float)extreme.height, extreme.isHigh);
+    }
+    int mutations = rng() % 4;
+    for (int m = 0; m < mutations && candidates.count > 0; m++) {
+        TideExtreme& item = candidates.items[rng() % candidates.count];
+        switch (rng() % 10) {
+            case 0:
+                std::swap(item, candidates.items[rng() % candidates.count]);
+                break;
+            case 1:
+                candidates.add(item.timestamp + (time_t)(rng() % 1800), item.height, item.isHigh);
+                break;
+            case 2:
+                item.timestamp += (time_t)(rng() % 40000) - 20000;
+                break;
+            case 3:
+                item.height = (float)uniform(rng, -8, 25);
+                break;
+            case 4:
+                item.isHigh = !item.isHigh;
+                break;
+            case 5:
+                item = candidates.items[--candidates.count];
+                break;
+            case 6:
+                item.height = rng() & 1 ? NAN : INFINITY;
+                break;
+            case 7:
+                item.timestamp = -(time_t)(rng() % 1000);
+                break;
+            case 8:
+                candidates.count = (int)(rng() % candidates.count);
+                break;
+            default:
+                while (!candidates.overflow) {
+                    candidates.add(item.timestamp, item.height, item.isHigh);
+                }
+                break;
+        }
+    }
+    return candidates;
+}
+
+bool contains(const TideCandidates& candidates, const TideExtreme& extreme) {
+    for (int i = 0; i < candidates.count; i++) {
+        if (sameExtreme(candidates.items[i], extreme)) return true;
+    }
+    return false;
+}
+
+// What a passed set promises the publisher, and that the reason given for a
+// rejection is true of the input
+void checkValidated(const TideCandidates& input, const TideCandidates& output, TideCheck result, time_t now) {
+    const TideValidationLimits& limits = DEFAULT_VALIDATION_LIMITS;
+    if (result == TideCheck::TOO_MANY) {
+        check(input.overflow, "rejected as too many without overflowing");
+        return;
+    }
+    check(!input.overflow, "an overflowing set was not rejected as too many");
+    bool badValue = false, outOfRange = false;
+    for (int i = 0; i < input.count; i++) {
+        badValue |= input.items[i].timestamp <= 0 || !std::isfinite(input.items[i].height);
+        outOfRange |= input.items[i].height < limits.minHeight || input.items[i].height > limits.maxHeight;
+    }
+    check(badValue == (result == TideCheck::BAD_VALUE), "bad values and the BAD_VALUE result disagree");
+    check(result != TideCheck::HEIGHT_RANGE || outOfRange, "rejected a height range that was fine");
+    if (result != TideCheck::OK) {
+        return;
+    }
+
+    check(output.count >= 2 && output.count <= input.count, "passed set has the wrong number of extremes");
+    check(output.items[0].timestamp <= now && output.items[output.count - 1].timestamp >= now + limits.minHorizonSec,
+        "passed set does not cover now and the day ahead");
+    for (int i = 0; i < output.count; i++) {
+        const TideExtreme& item = output.items[i];
+        check(contains(input, item), "passed set holds an extreme that was not in the input");
+        check(item.height >= limits.minHeight && item.height <= limits.maxHeight, "passed extreme outside the height limits");
+        if (i > 0) {
+            const TideExtreme& previous = output.items[i - 1];
+            time_t gap = item.timestamp - previous.timestamp;
+            check(gap >= limits.minSpacingSec && gap <= limits.maxSpacingSec, "passed extremes badly spaced");
+            check(item.isHigh != previous.isHigh && (item.isHigh ? item.height > previous.height : item.height < previous.height),
+                "passed extremes do not alternate");
+        }
+    }
+
+    // A clean set passes again unchanged
+    TideCandidates again = output;
+    check(TideValidator::validate(again, now) == TideCheck::OK && again.count == output.count,
+        "a passed set does not pass again");
+    for (int i = 0; i < output.count; i++) {
+        check(sameExtreme(again.items[i], output.items[i]), "a passed set changed on validating again");
+    }
+}
+
+// The string handling of the firmware before FixedString, rebuilt from the
+// baseline so the soak can compare heap behaviour. Parsed trees come from the
+// host's Arduino_JSON stand-in in both, and their allocations are counted
+// apart; building and printing a tree for the old save path is modelled on
+// cJSON's allocations.
+struct LegacyTideData {
+    String type;
+    float currentHeight;
+    TideExtreme current;
+    TideExtreme extremes[20];
+    int numExtremes;
+    unsigned long lastUpdateTime;
+};
+
+String legacyQuery(time_t startTime, time_t endTime) {
+    char startBuff[25], endBuff[25];
+    struct tm timeinfo;
+    gmtime_r(&startTime, &timeinfo);
+    strftime(startBuff, sizeof(startBuff), "%Y-%m-%dT%H:%M:%S", &timeinfo);
+    gmtime_r(&endTime, &timeinfo);
+    strftime(endBuff, sizeof(endBuff), "%Y-%m-%dT%H:%M:%S", &timeinfo);
+    return "{\"operationName\": \"GetTides\",\"variables\": {\"stationId\": \"" + String("8447525") + "\","
+           "\"startDateTime\": \"" + String(startBuff) + "\",\"endDateTime\": \"" + String(endBuff) + "\"},"
+           "\"query\": \"query GetTides($stationId: ID!, $startDateTime: String!, $endDateTime: String!) {\\n"
+           "  tides(\\n    stationId: $stationId\\n    startDateTime: $startDateTime\\n"
+           "    endDateTime: $endDateTime\\n  ) {\\n    localTime\\n    waterLevel\\n    tideType\\n"
+           "    timeZoneOffsetSeconds\\n    extremes {\\n      type\\n      timestamp\\n      height\\n"
+           "    }\\n  }\\n}\"}";
+}
+
+// JSON.stringify of a string: a quoted copy on the heap
+String legacyStringify(const JSONVar& value) {
+    const char* text = (const char*)value;
+    return text ? "\"" + String(text) + "\"" : String("null");
+}
+
+void legacyFetch(const String& payload, LegacyTideData& data, time_t now) {
+    JSONVar doc = JSON.parse(payload);
+    JSONVar tides = doc["data"]["tides"];
+    String typeStr = legacyStringify(tides["tideType"]);
+    data.type = typeStr.length() > 2 ? typeStr.substring(1, typeStr.length() - 1) : String("UNKNOWN");
+    data.currentHeight = (double)tides["waterLevel"];
+    data.lastUpdateTime = now;
+
+    JSONVar extremes = tides["extremes"];
+    data.numExtremes = 0;
+    for (int i = 0; i < extremes.length(); i++) {
+        time_t timestamp = (time_t)((double)extremes[i]["timestamp"] / 1000);
+        String extremeType = legacyStringify(extremes[i]["type"]);
+        TideExtreme extreme = { timestamp, (float)(double)extremes[i]["height"], extremeType.indexOf("HIGH") != -1 };
+        if (timestamp <= now) {
+            data.current = extreme;
+        } else if (data.numExtremes < 20) {
+            data.extremes[data.numExtremes++] = extreme;
+        }
+    }
+}
+
+// Building a cJSON tree through JSONVar and printing it unformatted: a node
+// per value, a copy of every key, and a print buffer that doubles as it fills
+class LegacyJsonTree {
+public:
+    LegacyJsonTree() : _count(0) {}
+    ~LegacyJsonTree() {
+        for (int i = 0; i < _count; i++) HostHeap::release(_blocks[i]);
+    }
+
+    void item(const char* key) {
+        _blocks[_count++] = HostHeap::allocate(40);
+        if (key != nullptr) _blocks[_count++] = HostHeap::allocate(strlen(key) + 1);
+    }
+    // serializeExtreme returned a JSONVar by value, which was duplicated into the array
+    void extreme() {
+        LegacyJsonTree temporary;
+        temporary.item(nullptr);
+        temporary.item("timestamp");
+        temporary.item("height");
+        temporary.item("isHigh");
+        item(nullptr);
+        item("timestamp");
+        item("height");
+        item("isHigh");
+    }
+    String print(const char* text) {
+        size_t length = strlen(text) + 1;
+        size_t size = 256;
+        void* buffer = HostHeap::allocate(size);
+        while (size < length) {
+            size = std::min(size * 2, length * 2);
+            HostHeap::release(buffer);
+            buffer = HostHeap::allocate(size);
+        }
+        void* printed = HostHeap::allocate(length);  // Shrunk to fit
+        HostHeap::release(buffer);
+        String result(text);
+        HostHeap::release(printed);
+        return result;
+    }
+
+private:
+    void* _blocks[512];
+    int _count;
+};
+
+TideData legacyToTideData(const LegacyTideData& data) {
+    TideData converted;
+    converted.type = parseTideType(data.type.c_str());
+    converted.currentHeight = data.currentHeight;
+    converted.lastUpdateTime = data.lastUpdateTime;
+    converted.current = data.current;
+    for (int i = 0; i < data.numExtremes; i++) {
+        converted.extremes.push(data.extremes[i]);
+    }
+    return converted;
+}
+
+void legacySave(const LegacyTideData& data, Preferences& preferences) {
+    String json;
+    {
+        LegacyJsonTree tree;
+        tree.item(nullptr);
+        tree.item("type");
+        tree.item(nullptr);  // The type's text
+        tree.item("currentHeight");
+        tree.item("lastUpdateTime");
+        tree.item("current");
+        tree.extreme();
+        tree.item("extremes");
+        for (int i = 0; i < data.numExtremes; i++) {
+            tree.extreme();
+        }
+        tree.item("numExtremes");
+        TideJsonBuffer text;
+        JsonHelper::serializeTideData(legacyToTideData(data), text);
+        json = tree.print(text.c_str());
+    }
+    preferences.clear();
+    preferences.putString(TIDE_DATA_KEY, json.c_str());
+}
+
+void legacyLoad(LegacyTideData& data, Preferences& preferences) {
+    String json = preferences.getString(TIDE_DATA_KEY, "");
+    JSONVar tideJson = JSON.parse(json);
+    data.type = (const char*)tideJson["type"];
+    data.currentHeight = (double)tideJson["currentHeight"];
+    data.lastUpdateTime = (unsigned long)(double)tideJson["lastUpdateTime"];
+    data.numExtremes = std::min((int)tideJson["numExtremes"], 20);
+    JSONVar extremes = tideJson["extremes"];
+    for (int i = 0; i < data.numExtremes; i++) {
+        data.extremes[i].timestamp = (time_t)(double)extremes[i]["timestamp"];
+        data.extremes[i].height = (double)extremes[i]["height"];
+        data.extremes[i].isHigh = (bool)extremes[i]["isHigh"];
+    }
+}
+
+// The debug build's per-frame status line
+void legacyRender(const LegacyTideData& data, time_t now) {
+    unsigned long timeToNext = data.numExtremes > 0 ? (unsigned long)(data.extremes[0].timestamp - now) : 0;
+    String duration = String((long)(timeToNext / 3600)) + "h " + String((long)(timeToNext % 3600 / 60)) + "m";
+    char timeBuff[50], zoneBuff[8];
+    struct tm timeinfo;
+    gmtime_r(&now, &timeinfo);
+    strftime(timeBuff, sizeof(timeBuff), "%a, %Y-%m-%d %H:%M:%S", &timeinfo);
+    strftime(zoneBuff, sizeof(zoneBuff), "%z", &timeinfo);
+    String local = String(timeBuff) + " " + String(zoneBuff);
+    Serial.printf("%s %s\n", duration.c_str(), local.c_str());
+}
+
+// Long-lived blocks that come and go while the firmware works, as the WiFi
+// and TCP/IP stacks hold buffers on the device. Without them nothing outlives
+// a cycle, and no allocation pattern could fragment the heap.
+class BackgroundChurn {
+public:
+    BackgroundChurn(int blocks, uint32_t seed) : _rng(seed), _blocks(blocks, nullptr), _steps(0) {}
+    ~BackgroundChurn() {
+        for (void* block : _blocks) HostHeap::release(block);
+    }
+
+    void step() {
+        if (_blocks.empty()) return;
+        void*& block = _blocks[_rng() % _blocks.size()];
+        HostHeap::release(block);
+        block = HostHeap::allocate(64 + _rng() % 1600);
+        _steps++;
+    }
+    unsigned long steps() const { return _steps; }
+
+private:
+    std::mt19937 _rng;
+    std::vector<void*> _blocks;
+    unsigned long _steps;
+};
+
+struct SoakResult {
+    HostHeap::Stats first;  // After one cycle
+    HostHeap::Stats last;
+    unsigned long backgroundAllocations;
+    size_t smallestLargestFree;
+    unsigned worstFragmentation;
+    double seconds;
+};
+
+template <typename Cycle>
+SoakResult runSoak(long cycles, size_t heapBytes, int background, uint32_t seed, Cycle cycle) {
+    SoakResult result = {};
+    BackgroundChurn churn(background, seed);
+    HostHeap::start(heapBytes);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long c = 0; c < cycles; c++) {
+        cycle(c, churn);
+        HostHeap::Stats stats = HostHeap::stats();
+        if (c == 0) {
+            result.first = stats;
+            result.smallestLargestFree = stats.largestFree;
+        }
+        result.smallestLargestFree = std::min(result.smallestLargestFree, stats.largestFree);
+        result.worstFragmentation = std::max(result.worstFragmentation, stats.fragmentation());
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.last = HostHeap::stats();
+    result.backgroundAllocations = churn.steps();
+    HostHeap::stop();
+    return result;
+}
+
+void printSoak(const char* name, const SoakResult& result, long cycles) {
+    printf("%s\n", name);
+    unsigned long firmware = result.last.allocations - result.backgroundAllocations;
+    printf("  %-34s %12.1f\n", "allocations per cycle", (double)firmware / cycles);
+    printf("  %-34s %12.1f\n", "  outside the JSON parser", (double)(firmware - result.last.libraryAllocations) / cycles);
+    printf("  %-34s %12zu %12zu\n", "in use between cycles (first, last)", result.first.used, result.last.used);
+    printf("  %-34s %12zu %12zu %12zu\n", "largest free block (first, last, min)",
+        result.first.largestFree, result.last.largestFree, result.smallestLargestFree);
+    printf("  %-34s %11u%% %11u%% %11u%%\n", "fragmentation (first, last, max)",
+        result.first.fragmentation(), result.last.fragmentation(), result.worstFragmentation);
+    printf("  %-34s %12zu\n", "peak use", result.last.peak);
+    printf("  %-34s %12lu\n", "failed allocations", result.last.failures);
+    printf("  %-34s %12.0f\n", "cycles per second", cycles / result.seconds);
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+bool checkRestore(const char* text, size_t length, TideData& data) {
+    std::string before = serialize(data);
+    if (!JsonHelper::deserializeTideData(text, length, data)) {
+        check(serialize(data) == before, "a rejected document changed the tide data");
+        return false;
+    }
+    checkFinite(data, "restore");
+    TideJsonBuffer again;
+    check(JsonHelper::serializeTideData(data, again), "restored data does not fit the JSON buffer");
+    TideData twice;
+    check(JsonHelper::deserializeTideData(again.c_str(), twice) && serialize(twice) == again.c_str(),
+        "restored data does not survive another save and restore");
+    return true;
+}
+
+bool checkResponse(const char* text, TideData& data, time_t now) {
+    std::string before = serialize(data);
+    if (!TideResponseParser::parse(text, data, now)) {
+        check(serialize(data) == before, "a rejected response changed the tide data");
+        return false;
+    }
+    checkPublished(data, now);
+    return true;
+}
+
+int fuzzJson(const Options& options) {
+    long iterations = std::stol(optional(options, "iterations", "200000"));
+    std::mt19937 rng((uint32_t)std::stoul(optional(options, "seed", "1")));
+    setHostTime(NOW);
+
+    // Saved state: mutated documents through the length-checked restore overload
+    std::vector<std::string> savedSeeds;
+    for (int i = 0; i < 8; i++) {
+        savedSeeds.push_back(serialize(randomTideData(rng)));
+    }
+    long restored = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        std::string text = savedSeeds[i % savedSeeds.size()];
+        mutate(text, rng);
+        TideData data = randomTideData(rng);
+        if (checkRestore(text.data(), text.size(), data)) {
+            restored++;
+        }
+    }
+    double restoreSeconds = secondsSince(start);
+
+    // API responses: mutated text through the parser and validator
+    std::vector<std::string> responseSeeds;
+    for (int i = 0; i < 8; i++) {
+        responseSeeds.push_back(renderResponse(randomResponse(rng, NOW), rng));
+    }
+    TideData seeded;
+    check(TideResponseParser::parse(responseSeeds[0].c_str(), seeded, NOW), "seed response rejected");
+    long accepted = 0;
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        std::string text = responseSeeds[i % responseSeeds.size()];
+        mutate(text, rng);
+        TideData data = seeded;
+        if (checkResponse(text.c_str(), data, NOW)) {
+            accepted++;
+        }
+    }
+    double responseSeconds = secondsSince(start);
+
+    printf("restore: %ld mutated documents in %.3f s, %.0f execs/s, %ld accepted\n",
+        iterations, restoreSeconds, iterations / restoreSeconds, restored);
+    printf("response: %ld mutated responses in %.3f s, %.0f execs/s, %ld accepted\n",
+        iterations, responseSeconds, iterations / responseSeconds, accepted);
+    return 0;
+}
+
+int fuzzValidator(const Options& options) {
+    long iterations = std::stol(optional(options, "iterations", "2000000"));
+    std::mt19937 rng((uint32_t)std::stoul(optional(options, "seed", "1")));
+    const int BATCH = 4096;
+
+    // Sets are generated and checked in batches so only validate() is timed
+    std::vector<TideCandidates> inputs(BATCH), outputs(BATCH);
+    std::vector<TideCheck> results(BATCH);
+    long counts[(int)TideCheck::HORIZON + 1] = {};
+    double seconds = 0;
+    for (long done = 0; done < iterations; done += BATCH) {
+        int batch = (int)std::min<long>(BATCH, iterations - done);
+        for (int i = 0; i < batch; i++) {
+            inputs[i] = randomCandidates(rng, NOW);
+        }
+        outputs = inputs;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < batch; i++) {
+            results[i] = TideValidator::validate(outputs[i], NOW);
+        }
+        seconds += secondsSince(start);
+        for (int i = 0; i < batch; i++) {
+            checkValidated(inputs[i], outputs[i], results[i], NOW);
+            counts[(int)results[i]]++;
+        }
+    }
+
+    printf("%ld candidate sets in %.3f s, %.0f validations/s\n", iterations, seconds, iterations / seconds);
+    for (int i = 0; i <= (int)TideCheck::HORIZON; i++) {
+        printf("  %-40s %ld\n", tideCheckName((TideCheck)i), counts[i]);
+    }
+    return 0;
+}
+
+int soak(const Options& options) {
+    long cycles = std::stol(optional(options, "cycles", "1000000"));
+    int renders = std::stoi(optional(options, "renders", "4"));
+    size_t heapBytes = (size_t)std::stoul(optional(options, "heap-kb", "200")) * 1024;
+    int background = std::stoi(optional(options, "background", "48"));
+    uint32_t seed = (uint32_t)std::stoul(optional(options, "seed", "1"));
+    std::mt19937 rng(seed);
+
+    // Responses six hours apart, as the update interval fetches them
+    struct Fetch {
+        time_t now;
+        std::string text;
+    };
+    std::vector<Fetch> fetches;
+    for (int i = 0; i < 64; i++) {
+        time_t now = NOW + i * 6 * 3600;
+        fetches.push_back({ now, renderResponse(randomResponse(rng, now), rng) });
+    }
+    PreferencesManager::initialize();
+    Preferences legacyPreferences;
+    legacyPreferences.begin("soaklegacy");
+
+    LegacyTideData legacy;
+    legacy.numExtremes = 0;
+    SoakResult before = runSoak(cycles, heapBytes, background, seed, [&](long cycle, BackgroundChurn& churn) {
+        const Fetch& fetch = fetches[cycle % fetches.size()];
+        setHostTime(fetch.now);
+        {
+            String query = legacyQuery(fetch.now - 86400, fetch.now + 5 * 86400);
+            churn.step();
+            String payload = fetch.text.c_str();
+            legacyFetch(payload, legacy, fetch.now);
+        }
+        churn.step();
+        legacySave(legacy, legacyPreferences);
+        churn.step();
+        legacyLoad(legacy, legacyPreferences);
+        for (int r = 0; r < renders; r++) {
+            legacyRender(legacy, fetch.now + r * 60);
+            churn.step();
+        }
+    });
+
+    TideData data;
+    FrameRenderer renderer;
+    const WaveSettings wave = { 4000, 8000 };
+    SoakResult after = runSoak(cycles, heapBytes, background, seed, [&](long cycle, BackgroundChurn& churn) {
+        const Fetch& fetch = fetches[cycle % fetches.size()];
+        setHostTime(fetch.now);
+        {
+            // The query is built in a stack buffer; the response still arrives as a String
+            churn.step();
+            String payload = fetch.text.c_str();
+            check(TideResponseParser::parse(payload.c_str(), data, fetch.now), "soak response rejected");
+        }
+        churn.step();
+        check(PreferencesManager::saveTideData(data), "soak save failed");
+        churn.step();
+        check(PreferencesManager::loadTideData(data), "soak load failed");
+        if (cycle % fetches.size() == 0) {
+            renderer = FrameRenderer();  // Time starts again with the responses
+            renderer.seed(1);
+        }
+        for (int r = 0; r < renders; r++) {
+            TideFrame frame;
+            time_t now = fetch.now + r * 60;
+            renderer.render(data.extremes, data.current, data.blend, now, (uint32_t)(cycle * 1000 + r), wave, frame);
+            DurationString duration;
+            duration.appendf("%luh %lum", (unsigned long)(frame.next.timestamp - now) / 3600,
+                (unsigned long)(frame.next.timestamp - now) % 3600 / 60);
+            Serial.printf("%s %06X\n", duration.c_str(), (unsigned)frame.color);
+            churn.step();
+        }
+    });
+
+    printf("%ld fetch/save/load/render cycles on a %zu KB model heap, %d background blocks\n",
+        cycles, heapBytes / 1024, background);
+    printSoak("before: String", before, cycles);
+    printSoak("after: FixedString", after, cycles);
+    return 0;
+}
+
+int properties(const Options& options) {
+    long iterations = std::stol(optional(options, "iterations", "20000"));
+    std::mt19937 rng((uint32_t)std::stoul(optional(options, "seed", "1")));
+    setHostTime(NOW);
+
+    for (long i = 0; i < iterations; i++) {
+        TideData data = randomTideData(rng);
+        std::string saved = serialize(data);
+        TideData restored;
+        check(JsonHelper::deserializeTideData(saved.data(), saved.size(), restored), "saved data did not restore: " + saved);
+        check(serialize(restored) == saved, "save, restore, save changed the document: " + saved);
+        check(restored.type == data.type && restored.lastUpdateTime == data.lastUpdateTime &&
+              sameExtreme(restored.current, data.current) && restored.extremes.size() == data.extremes.size(),
+            "restore changed the tide data: " + saved);
+        for (int e = 0; e < data.extremes.size(); e++) {
+            check(sameExtreme(restored.extremes.at(e), data.extremes.at(e)), "restore changed an extreme: " + saved);
+        }
+        // Saved to six significant digits, well under a millimeter
+        check(std::fabs(restored.currentHeight - data.currentHeight) <= 1e-5f * std::max(1.0f, std::fabs(data.currentHeight)),
+            "restore changed the current height: " + saved);
+
+        // Saved data belongs to the station it was saved for
+        setHostStation("9414290");
+        TideData other = randomTideData(rng);
+        std::string untouched = serialize(other);
+        check(!JsonHelper::deserializeTideData(saved.data(), saved.size(), other), "restored another station's data");
+        check(serialize(other) == untouched, "another station's data changed the tide data");
+        setHostStation(DeviceConfig::defaults().stationId);
+    }
+
+    for (long i = 0; i < iterations; i++) {
+        time_t now = NOW + (time_t)(rng() % 86400);
+        ResponseModel model = randomResponse(rng, now);
+        std::string text = renderResponse(model, rng);
+        TideData data;
+        check(TideResponseParser::parse(text.c_str(), data, now), "valid response rejected: " + text);
+        checkAgainstModel(data, model, now);
+        checkPublished(data, now);
+    }
+
+    printf("%ld save/restore round trips and %ld generated responses matched their models\n", iterations, iterations);
+    return 0;
+}
+
+int configLoad(const Options& options) {
+    long iterations = std::stol(optional(options, "iterations", "20000"));
+    Preferences::eraseAll();
+
+    // A profile saved from the console, and saved tide data with a full
+    // timeline, the largest the restore handles
+    ConfigManager::initialize();
+    check(ConfigManager::handleCommand("config set brightness 40"), "config set not handled");
+    check(ConfigManager::handleCommand("config save"), "config save not handled");
+    TideData data;
+    data.type = TideType::RISING;
+    data.lastUpdateTime = (unsigned long)NOW;
+    data.current = { NOW, 1.2f, false };
+    for (int i = 0; i < TideTimeline::CAPACITY; i++) {
+        data.extremes.push(NOW + i * 22320, (i & 1) ? 0.2f : 2.9f, (i & 1) == 0);
+    }
+    PreferencesManager::initialize();
+    check(PreferencesManager::saveTideData(data), "tide data not saved");
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        ConfigManager::initialize();
+    }
+    double configUs = secondsSince(start) * 1e6 / iterations;
+    check(ConfigManager::get().brightness == 40, "the saved profile was not loaded");
+
+    TideData restored;
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        check(PreferencesManager::loadTideData(restored), "saved tide data not restored");
+    }
+    double restoreUs = secondsSince(start) * 1e6 / iterations;
+    printf("config load %.2f us, tide data restore %.2f us (%.1fx)\n", configUs, restoreUs, restoreUs / configUs);
+    check(configUs < restoreUs, "loading the profile took longer than restoring the tide data");
+
+    // "config show" lists the active profile, then unsaved edits apart from it
+    std::string output;
+    Serial.capture(&output);
+    ConfigManager::handleCommand("config set brightness 50");
+    output.clear();
+    ConfigManager::handleCommand("config show");
+    size_t active = output.find("  brightness   40\n");
+    size_t header = output.find("Not saved");
+    size_t edit = output.find("* brightness   50\n");
+    check(active != std::string::npos && header != std::string::npos && edit != std::string::npos &&
+          active < header && header < edit,
+        "config show did not list the active brightness, then the edit: " + output);
+    check(output.find("* station") == std::string::npos, "config show marked an unchanged field: " + output);
+
+    ConfigManager::handleCommand("config set brightness 40");
+    output.clear();
+    ConfigManager::handleCommand("config show");
+    Serial.capture(nullptr);
+    check(output.find("Not saved") == std::string::npos, "config show listed edits that match the profile: " + output);
+
+    printf("config show lists the active profile and unsaved edits apart\n");
+    return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <ctime>
+#include "Options.h"
+#include "models/TideData.h"
+
+// Host runs of the firmware's JSON, validation and storage code, built
+// against the Arduino stand-ins in host/. Configure with
+// -DTIDETABLE_SANITIZE=ON to run them under ASan and UBSan.
+
+// One input each, as the fuzz commands and the libFuzzer targets in fuzz/
+// run them. Both return whether the input was accepted, and throw
+// std::runtime_error if the firmware broke a promise: an accepted input must
+// give finite, well-ordered data, a rejected one must leave data as it was.
+bool checkRestore(const char* text, size_t length, TideData& data);
+bool checkResponse(const char* text, TideData& data, time_t now);  // text NUL terminated
+
+// Mutated saved-state documents through JsonHelper's restore path and
+// mutated API responses through TideResponseParser, checking whatever
+// either accepts and that a rejected input leaves the data alone
+int fuzzJson(const Options& options);
+
+// Mutated candidate sets straight through TideValidator, checking every set
+// it passes and reporting validations per second
+int fuzzValidator(const Options& options);
+
+// Millions of fetch/save/load/render cycles through the firmware's code and
+// through a rebuild of its String-based original, on a model heap, reporting
+// peak use and fragmentation after the first cycle and the last
+int soak(const Options& options);
+
+// Serialize/deserialize round trips of random tide data, and generated API
+// responses parsed and compared with the model they were generated from
+int properties(const Options& options);
+
+// Load time of the device profile through ConfigManager against the restore
+// of a full timeline of saved tide data, both from the Preferences stand-in;
+// fails if the profile is the slower. Also checks that "config show" lists
+// unsaved edits apart from the active profile.
+int configLoad(const Options& options);
@@ -0,0 +1,230 @@
+/*
+ * Created on Tue Jan 21 2025
+ *
+ * Copyright (c) 2025 Bernard Bernstein
+ * MIT License - See LICENSE file in the project root for full license information.
+ */
+
+#include "PushChecks.h"
+#include <Adafruit_NeoPixel.h>
+#include <LittleFS.h>
+#include <PubSubClient.h>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include "FirmwareHost.h"
+#include "TableChecks.h"
+#include "display/LedController.h"
+#include "services/ProvisioningService.h"
+#include "services/PushService.h"
+#include "storage/TideTableStore.h"
+
+namespace {
+
+const char STATION[] = "8447525";
+const char PATCH_TOPIC[] = "tides/8447525/patch";
+const char LEVEL_TOPIC[] = "tides/8447525/level";
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        throw std::runtime_error("push: " + what);
+    }
+}
+
+class PushRun {
+public:
+    PushRun(const SigningKey& key, const TableContents& table, time_t now) : key(key), table(table), now(now) {}
+
+    // Replaces record index of the table as it stands at fromRevision
+    std::vector<uint8_t> patch(uint32_t fromRevision, uint32_t index, int16_t heightCm) const {
+        TideTablePatchInfo info = {};
+        TideTableCodec::setStationId(info.stationId, STATION);
+        info.fromRevision = fromRevision;
+        info.toRevision = fromRevision + 1;
+        info.count = 1;
+        TideTablePatchEntry entry = { index, table.records[index] };
+        entry.record.heightCm = heightCm;
+        VectorSink sink;
+        TideTableCodec::encodePatch(info, &entry, sink);
+        appendSignature(sink.bytes, key);
+        return sink.bytes;
+    }
+
+    std::vector<uint8_t> level(const char* station, uint32_t sequence, time_t time, int16_t heightCm) const {
+        TideLevelReading reading = {};
+        TideTableCodec::setStationId(reading.stationId, station);
+        reading.sequence = sequence;
+        reading.timestamp = time;
+        reading.heightCm = heightCm;
+        VectorSink sink;
+        TideTableCodec::encodeLevel(reading, sink);
+        appendSignature(sink.bytes, key);
+        return sink.bytes;
+    }
+
+    // One pass of the firmware's loop() as far as push mode goes. Returns the
+    // microseconds from the pass starting to the LED showing a new frame, or
+    // -1 if it didn't.
+    long pass(TideData& data) {
+        unsigned long shows = Adafruit_NeoPixel::lastShown().count;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        PushService::loop();
+        LedController::updateDisplay(data);
+        if (Adafruit_NeoPixel::lastShown().count == shows) {
+            return -1;
+        }
+        return (long)std::chrono::duration_cast<std::chrono::microseconds>(
+            Adafruit_NeoPixel::lastShown().at - start).count();
+    }
+
+    // Whether a catch-up was asked for since the last call, far enough apart
+    // that PUSH_CATCHUP_INTERVAL_MS never holds one back
+    bool catchUpRequested() {
+        catchUpMillis += PUSH_CATCHUP_INTERVAL_MS * 2;
+        return PushService::takeCatchUp(catchUpMillis);
+    }
+
+    uint32_t revision() const {
+        TideTableInfo info;
+        check(TideTableStore::readInfo(info), "no stored table");
+        return info.revision;
+    }
+
+    // The shown extremes hold record index with heightCm
+    void expectShown(const TideData& data, uint32_t index, int16_t heightCm) const {
+        time_t time = table.info.baseTime + table.records[index].offset;
+        for (int i = 0; i < data.extremes.size(); i++) {
+            if (data.extremes.at(i).timestamp == time) {
+                check(std::lround(data.extremes.at(i).height * 100) == heightCm,
+                    "extreme " + std::to_string(index) + " not patched on the display");
+                return;
+            }
+        }
+        throw std::runtime_error("push: extreme " + std::to_string(index) + " not in the shown window");
+    }
+
+    const SigningKey& key;
+    const TableContents& table;
+    time_t now;
+    unsigned long catchUpMillis = 0;
+};
+
+void expectBlend(const TideData& data, const TideData& expected, const char* when) {
+    check(data.blend.observations == expected.blend.observations && data.blend.offset == expected.blend.offset &&
+          data.blend.variance == expected.blend.variance && data.blend.observedAt == expected.blend.observedAt &&
+          data.currentHeight == expected.currentHeight,
+        std::string("blended level differs from the expected readings ") + when);
+}
+
+}
+
+int push(const Options&) {
+    if (!ProvisioningService::hasPublicKey()) {
+        printf("wifi_credentials.h has the placeholder TIDE_TABLE_PUBLIC_KEY; skipped\n");
+        return 77;
+    }
+
+    // Three days into a 30-day table at revision 1, stored as a download stores it
+    TableContents table = syntheticTable(30);
+    table.info.revision = 1;
+    const time_t now = table.info.baseTime + 3 * 86400;
+    setHostTime(now);
+    setHostStation(STATION);
+    SigningKey key = SigningKey::generate();
+    setHostTablePublicKey(key.publicKey());
+    LittleFS.format();
+    check(TideTableStore::beginTable(table.info), "beginTable failed");
+    for (const TideTableRecord& record : table.records) {
+        check(TideTableStore::appendRecord(record), "appendRecord failed");
+    }
+    check(TideTableStore::commitTable(), "commitTable failed");
+
+    TideData data;
+    check(TideTableStore::loadWindow(data, now), "no window at now");
+    // What the blend should be: the same window, given only the readings
+    // that ought to be taken. Patches only touch extremes after the readings.
+    TideData expected = data;
+    int next = data.extremes.upperBound(now);
+    uint32_t first = 0;
+    while (table.info.baseTime + table.records[first].offset <= now) {
+        first++;
+    }
+    uint32_t patched = first + (uint32_t)next + 2;  // Two extremes ahead of the next one
+
+    PushRun run(key, table, now);
+    PushService::begin(data);
+    long slowest = 0;
+    auto arrived = [&](const char* what) {
+        long micros = run.pass(data);
+        check(micros >= 0, std::string(what) + " didn't reach the LED in the pass it arrived in");
+        slowest = std::max(slowest, micros);
+        printf("%-34s %6ld us to the LED\n", what, micros);
+    };
+
+    // Retained before the device connects: both arrive on subscribe
+    PubSubClient::publish(PATCH_TOPIC, run.patch(1, patched, 321), true);
+    PubSubClient::publish(LEVEL_TOPIC, run.level(STATION, 10, now - 600, 142), true);
+    run.pass(data);  // Connects and subscribes
+    check(PushService::isConnected(), "didn't connect");
+    check(run.catchUpRequested(), "no catch-up after connecting");
+    arrived("retained patch 1->2 and level 10");
+    check(run.revision() == 2, "retained patch not applied");
+    run.expectShown(data, patched, 321);
+    expected.observeLevel(now - 600, 1.42f);
+    expectBlend(data, expected, "after the retained reading");
+
+    // A reconnect resubscribes and the broker sends both again
+    PubSubClient::dropConnection();
+    run.pass(data);
+    check(PushService::isConnected(), "didn't reconnect");
+    run.catchUpRequested();  // Every connect asks for one
+    run.pass(data);
+    check(run.revision() == 2, "resent retained patch changed the table");
+    expectBlend(data, expected, "after the resent retained reading");
+
+    // Duplicates while connected: dropped without a catch-up
+    PubSubClient::publish(PATCH_TOPIC, run.patch(1, patched, 321), false);
+    PubSubClient::publish(LEVEL_TOPIC, run.level(STATION, 10, now - 600, 142), false);
+    run.pass(data);
+    check(run.revision() == 2 && !run.catchUpRequested(), "duplicate patch not dropped quietly");
+    expectBlend(data, expected, "after a duplicate reading");
+
+    // Out of order, in one pass: 3->4 before 2->3 is a gap, so it asks for a
+    // catch-up, then 2->3 applies. Reading 12 is taken and 11 then refused.
+    PubSubClient::publish(PATCH_TOPIC, run.patch(3, patched + 1, 222), false);
+    PubSubClient::publish(PATCH_TOPIC, run.patch(2, patched, 333), false);
+    PubSubClient::publish(LEVEL_TOPIC, run.level(STATION, 12, now - 300, 151), false);
+    PubSubClient::publish(LEVEL_TOPIC, run.level(STATION, 11, now - 400, 90), false);
+    arrived("patches 3->4, 2->3, levels 12, 11");
+    check(run.revision() == 3, "in-order patch not applied after a gap");
+    check(run.catchUpRequested(), "gap didn't ask for a catch-up");
+    run.expectShown(data, patched, 333);
+    expected.observeLevel(now - 300, 1.51f);
+    expectBlend(data, expected, "after readings out of order");
+
+    PubSubClient::publish(PATCH_TOPIC, run.patch(3, patched + 1, 222), false);
+    arrived("patch 3->4 again");
+    check(run.revision() == 4 && !run.catchUpRequested(), "resent patch not applied");
+    run.expectShown(data, patched + 1, 222);
+
+    // Readings for another station, forged, too old, or from too far ahead
+    std::vector<uint8_t> forged = run.level(STATION, 20, now - 60, 300);
+    forged[forged.size() - 1] ^= 1;
+    PubSubClient::publish(LEVEL_TOPIC, run.level("9414290", 21, now - 60, 300), false);
+    PubSubClient::publish(LEVEL_TOPIC, forged, false);
+    PubSubClient::publish(LEVEL_TOPIC, run.level(STATION, 22, now - PUSH_LEVEL_MAX_AGE_SEC - 1, 300), false);
+    PubSubClient::publish(LEVEL_TOPIC, run.level(STATION, 23, now + PUSH_LEVEL_MAX_AHEAD_SEC + 1, 300), false);
+    run.pass(data);
+    expectBlend(data, expected, "after refused readings");
+
+    // More patches in one pass than the queue holds: the rest is left to the catch-up
+    PubSubClient::publish(PATCH_TOPIC, run.patch(4, patched + 2, 100), false);
+    PubSubClient::publish(PATCH_TOPIC, run.patch(5, patched + 3, 101), false);
+    PubSubClient::publish(PATCH_TOPIC, run.patch(6, patched + 4, 102), false);
+    arrived("patches 4->5, 5->6, 6->7");
+    check(run.revision() == 4 + PUSH_PATCH_QUEUE_DEPTH, "queued patches not applied in order");
+    check(run.catchUpRequested(), "overflowing the queue didn't ask for a catch-up");
+
+    printf("revision %u, %u readings blended, slowest pass %ld us\n", run.revision(), data.blend.observations, slowest);
+    return 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "Options.h"
+
+// Drives the firmware's PushService, TideTableStore and LedController
+// through the PubSubClient stand-in's broker. The broker delivers retained,
+// duplicate, out-of-order, misdirected and forged patches and level readings.
+// Checks after each round:
+// - the stored table revision and the extremes on show
+// - the blend state against a replay of just the readings that should be taken
+// - whether a catch-up was asked for
+// - that the LED changed in the loop pass the message arrived in
+// Reports the time from a pass starting to the LED showing the result.
+// Returns 77, ctest's skip code, if wifi_credentials.h has the placeholder key.
+int push(const Options& options);
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+#include "Options.h"
+#include "TableFile.h"
+
+// Host runs of the firmware's table decoder, timeline, frame renderer and
+// clock drift estimator. Each works on a synthetic table unless given files.
+
+// A year or so of plausible extremes for one station, the same every run
+TableContents syntheticTable(int days);
+
+// Checks the decoder's promises while it is fed arbitrary bytes
+class CheckingListener : public TideTableDecoder::Listener {
+public:
+    void onSignedBytes(const uint8_t*, size_t length) override { signedBytes += length; }
+    bool onHeader(const TideTableInfo& info) override {
+        check(headers++ == 0, "second header");
+        check(info.count <= TIDE_TABLE_MAX_RECORDS, "record count over the limit");
+        check(info.stationId[TIDE_TABLE_STATION_ID_SIZE - 1] == '\0', "station id not terminated");
+        count = info.count;
+        return true;
+    }
+    bool onRecord(const TideTableRecord&) override {
+        check(headers == 1 && records++ < count, "record outside the header's count");
+        return true;
+    }
+
+    static void check(bool condition, const char* what) {
+        if (!condition) {
+            throw std::runtime_error(std::string("decoder invariant broken: ") + what);
+        }
+    }
+
+    size_t signedBytes = 0;
+    uint32_t headers = 0;
+    uint32_t count = 0;
+    uint32_t records = 0;
+};
+
+// Decoder throughput, the same code path the firmware runs while streaming.
+// --input and --key pick a real table.
+int bench(const Options& options);
+
+// Lookup cost of the firmware's extreme timeline at 20 to 10,000 entries
+// against the linear scan it replaced
+int timelineBench(const Options& options);
+
+// Feeds mutated copies of a table through the streaming decoder, and mutated
+// patches through parsePatch, checking invariants as it goes. Doubles as a
+// throughput benchmark in execs per second. Build with -DTIDETABLE_SANITIZE=ON
+// to have memory errors and UB reported as well.
+int fuzzTable(const Options& options);
+
+// Plays predicted tides through the firmware's FrameRenderer twice: a frame
+// at a time as updateDisplay does, and in FrameQueue chunks as playFrames
+// does between light sleeps. Fresh data falls due every --update seconds and
+// the first update fails for --outage seconds, as when WiFi is down. Fails if
+// a colour differs or a chunk comes out empty while the extremes cover now,
+// which would freeze the LED, or if a frame's corrected extremes don't
+// bracket now. --observed folds levels up to --start into the blend first.
+int frames(const Options& options);
+
+// Simulates an RTC running --ppm fast against true time, with a daily
+// swing of --wander ppm, synced by SNTP with --noise-ms of error: once at
+// boot, again --resync seconds later as after a restart, then whenever the
+// firmware's ClockDrift says the corrected clock may be more than
+// --tolerance seconds off. Checked each simulated minute; fails if the
+// corrected clock is ever further off than ClockDrift predicted.
+int drift(const Options& options);
+
+// Signs RFC 6979's P-256/SHA-256 test messages with its key and compares
+// with its signatures, then checks random messages sign the same way twice
+// and verify
+int signing(const Options& options);